@@ -0,0 +1,241 @@
+// Coût hôte des mises à jour de chaîne quand un seul thread pilote plusieurs
+// adaptateurs : appels système et temps CPU (utilisateur + noyau, threads
+// io-wq compris) pour 1000 mises à jour, io_uring contre write/poll/read.
+// Sans --device, chaque adaptateur est un MCP2210Simulator dans un processus
+// fils, relié par une socketpair SOCK_SEQPACKET (un datagramme par rapport,
+// comme hidraw) ; le coût des simulateurs n'est pas compté.
+//
+// Linux uniquement :
+//   g++ -std=c++17 -O2 -pthread -Iinclude bench/hidraw_bench.cpp src/HidrawUring.cpp src/MCP2210Simulator.cpp
+//       src/ChainLayout.cpp src/mcp2210.cpp src/MCP2210Transport.cpp -lhidapi-hidraw -o hidraw_bench
+//
+// Usage : hidraw_bench [--adapters <n>] [--updates <n>] [--backend uring|blocking|both]
+//                      [--latency-us <µs>] [--device /dev/hidrawN]...
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "HidrawUring.h"
+#include "MCP2210Simulator.h"
+#include "ChainLayout.h"
+
+#define HIDRAW_BENCH_WARMUP 10
+
+struct BenchOptions {
+    size_t adapters;
+    unsigned long updates;
+    long latencyUs;
+    std::vector<std::string> devices; // Adaptateurs réels : remplace les simulateurs
+};
+
+struct BenchResult {
+    HidrawBackend backend;
+    std::string fallbackReason;
+    size_t adapters;
+    unsigned long chainUpdates;
+    unsigned long syscalls;
+    unsigned long rounds;
+    double userMs;
+    double systemMs;
+    double wallMs;
+    unsigned long failures;
+};
+
+// Un MCP2210 simulé par processus : le point d'accroche du simulateur est global
+static void serveSimulator(int fd, long latencyUs) {
+    MCP2210Simulator simulator(NUM_POTS, std::chrono::microseconds(latencyUs));
+    simulator.install();
+    hid_device* handle = InitMCP2210();
+
+    byte cmd[COMMAND_BUFFER_LENGTH];
+    byte rsp[RESPONSE_BUFFER_LENGTH];
+    for (;;) {
+        ssize_t n = read(fd, cmd, COMMAND_BUFFER_LENGTH);
+        if (n <= 0) break;
+        std::memset(rsp, 0, RESPONSE_BUFFER_LENGTH);
+        SendUSBCmd(handle, cmd, rsp);
+        if (write(fd, rsp, RESPONSE_BUFFER_LENGTH) < 0) break;
+    }
+}
+
+class SimulatedAdapters {
+public:
+    SimulatedAdapters(size_t count, long latencyUs) {
+        for (size_t i = 0; i < count; ++i) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, pair) < 0) {
+                throw std::runtime_error("Erreur : socketpair impossible.");
+            }
+            pid_t pid = fork();
+            if (pid < 0) {
+                throw std::runtime_error("Erreur : fork impossible.");
+            }
+            if (pid == 0) {
+                // Les extrémités des autres simulateurs restent côté parent : fin de flux à leur fermeture
+                close(pair[0]);
+                for (int fd : parentEnds) close(fd);
+                serveSimulator(pair[1], latencyUs);
+                _exit(0);
+            }
+            close(pair[1]);
+            parentEnds.push_back(pair[0]);
+            children.push_back(pid);
+        }
+    }
+
+    ~SimulatedAdapters() {
+        for (int fd : parentEnds) close(fd);
+        for (pid_t pid : children) waitpid(pid, NULL, 0);
+    }
+
+    // Le lot devient propriétaire des descripteurs
+    void attach(HidrawUring& batch) {
+        for (int& fd : parentEnds) {
+            batch.adoptDevice(fd);
+            fd = -1;
+        }
+        parentEnds.clear();
+    }
+
+private:
+    std::vector<int> parentEnds;
+    std::vector<pid_t> children;
+};
+
+static double timevalMs(const struct timeval& tv) {
+    return tv.tv_sec * 1e3 + tv.tv_usec / 1e3;
+}
+
+static BenchResult runBackend(HidrawBackend backend, const BenchOptions& options) {
+    size_t adapters = options.devices.empty() ? options.adapters : options.devices.size();
+    std::unique_ptr<SimulatedAdapters> simulated;
+    if (options.devices.empty()) {
+        simulated.reset(new SimulatedAdapters(adapters, options.latencyUs));
+    }
+
+    BenchResult result = BenchResult();
+    {
+        HidrawUring batch(adapters, backend);
+        if (simulated) {
+            simulated->attach(batch);
+        } else {
+            for (const std::string& path : options.devices) batch.openDevice(path);
+        }
+
+        std::vector<std::vector<uint8_t>> frames(adapters, std::vector<uint8_t>(MainChainLayout::frameLength));
+        std::vector<uint8_t*> data(adapters);
+        for (size_t i = 0; i < adapters; ++i) data[i] = frames[i].data();
+        std::vector<uint16_t> values(NUM_POTS);
+        std::vector<HidrawTransferResult> transfers;
+
+        // Une mise à jour : une nouvelle consigne codée et transférée sur chaque adaptateur
+        auto update = [&](unsigned long u) {
+            for (size_t i = 0; i < adapters; ++i) {
+                for (size_t p = 0; p < NUM_POTS; ++p) {
+                    values[p] = static_cast<uint16_t>((u * 7 + i * 13 + p) & 0xFF);
+                }
+                MainChainLayout::encodeWrite(values.data(), data[i]);
+            }
+            batch.spiTransfer(data.data(), MainChainLayout::frameLength, transfers);
+            for (const HidrawTransferResult& transfer : transfers) {
+                if (transfer.status != 0) result.failures++;
+            }
+        };
+
+        for (unsigned long u = 0; u < HIDRAW_BENCH_WARMUP; ++u) update(u);
+        result.failures = 0;
+
+        unsigned long syscallsBefore = batch.syscalls();
+        unsigned long roundsBefore = batch.rounds();
+        struct rusage before;
+        getrusage(RUSAGE_SELF, &before);
+        auto start = std::chrono::steady_clock::now();
+
+        for (unsigned long u = 0; u < options.updates; ++u) update(u);
+
+        result.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        struct rusage after;
+        getrusage(RUSAGE_SELF, &after);
+        result.userMs = timevalMs(after.ru_utime) - timevalMs(before.ru_utime);
+        result.systemMs = timevalMs(after.ru_stime) - timevalMs(before.ru_stime);
+        result.syscalls = batch.syscalls() - syscallsBefore;
+        result.rounds = batch.rounds() - roundsBefore;
+        result.backend = batch.backend();
+        result.fallbackReason = batch.fallbackReason();
+    }
+    result.adapters = adapters;
+    result.chainUpdates = options.updates * adapters;
+    return result;
+}
+
+static void printResult(const BenchResult& r) {
+    double per1000 = 1000.0 / r.chainUpdates;
+    std::cout << std::left << std::setw(10) << (r.backend == HidrawBackend::Uring ? "io_uring" : "bloquant")
+              << std::right << std::setw(6) << r.adapters << std::setw(10) << r.chainUpdates
+              << std::fixed << std::setprecision(1)
+              << std::setw(14) << r.syscalls * per1000
+              << std::setw(12) << r.userMs * per1000
+              << std::setw(12) << r.systemMs * per1000
+              << std::setw(12) << r.wallMs * per1000
+              << std::setw(10) << static_cast<double>(r.rounds) / (r.chainUpdates / r.adapters)
+              << std::setw(8) << r.failures << std::endl;
+    if (!r.fallbackReason.empty()) {
+        std::cout << "          repli : " << r.fallbackReason << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    options.adapters = 12;
+    options.updates = 1000;
+    options.latencyUs = 0;
+    std::string backends = "both";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--adapters" && i + 1 < argc) {
+            options.adapters = std::stoul(argv[++i]);
+        } else if (arg == "--updates" && i + 1 < argc) {
+            options.updates = std::stoul(argv[++i]);
+        } else if (arg == "--backend" && i + 1 < argc) {
+            backends = argv[++i];
+        } else if (arg == "--latency-us" && i + 1 < argc) {
+            options.latencyUs = std::stol(argv[++i]);
+        } else if (arg == "--device" && i + 1 < argc) {
+            options.devices.push_back(argv[++i]);
+        } else {
+            std::cerr << "Usage : " << argv[0] << " [--adapters <n>] [--updates <n>] [--backend uring|blocking|both]\n"
+                      << "                    [--latency-us <µs>] [--device /dev/hidrawN]..." << std::endl;
+            return 1;
+        }
+    }
+    if (options.adapters == 0 || options.updates == 0 || (backends != "uring" && backends != "blocking" && backends != "both")) {
+        std::cerr << "Erreur : paramètres de mesure invalides." << std::endl;
+        return 1;
+    }
+    // Un simulateur terminé ne doit pas interrompre la mesure
+    signal(SIGPIPE, SIG_IGN);
+
+    std::cout << std::left << std::setw(10) << "transport" << std::right << std::setw(6) << "adapt."
+              << std::setw(10) << "chaînes" << std::setw(14) << "appels/1000" << std::setw(12) << "user ms"
+              << std::setw(12) << "noyau ms" << std::setw(12) << "mur ms" << std::setw(10) << "tours/maj"
+              << std::setw(8) << "échecs" << std::endl;
+    try {
+        if (backends != "blocking") printResult(runBackend(HidrawBackend::Uring, options));
+        if (backends != "uring") printResult(runBackend(HidrawBackend::Blocking, options));
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
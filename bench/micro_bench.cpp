@@ -0,0 +1,255 @@
+// Micro-benchmarks du coût hôte : codage/décodage des trames de chaîne,
+// construction des rapports MCP2210 et copies de SPIDataTransferStatusDef.
+// Le transport est nul (périphérique virtuel qui répond immédiatement) :
+// les mesures excluent toute latence USB.
+//
+// Usage : micro_bench [--filter <noyau>] [--min-ms <durée>] [--json <fichier|->]
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "mcp2210.h"
+#include "ChainLayout.h"
+
+#define MICRO_BENCH_REPETITIONS 5
+
+static const size_t CHAIN_LENGTHS[] = {1, 2, 4, 8, 16, 32, 64, 128, 256};
+
+// Empêche le compilateur d'éliminer un calcul dont le résultat n'est pas utilisé
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+// Transport nul : chaque commande réussit, un transfert SPI rend ses octets terminés
+static int nullTransport(void*, byte* cmdBuf, byte* responseBuf) {
+    responseBuf[0] = cmdBuf[0];
+    responseBuf[1] = 0x00;
+    if (cmdBuf[0] == CMD_SPI_TRANSFER) {
+        responseBuf[2] = cmdBuf[1];
+        responseBuf[3] = SPI_STATUS_FINISHED_NO_DATA_TO_SEND;
+        std::memcpy(responseBuf + 4, cmdBuf + 4, cmdBuf[1]);
+    }
+    return 0;
+}
+
+struct MicroResult {
+    std::string kernel;
+    size_t chainLength;
+    size_t bytes;          // Octets SPI traités par opération
+    double nsPerOp;        // Meilleure répétition
+    unsigned long iterations;
+};
+
+// Contexte partagé par les noyaux : tampons préparés hors de la mesure
+struct KernelContext {
+    hid_device* handle;
+    ChainLayout uniform;
+    ChainLayout mixed;
+    std::vector<uint16_t> values;
+    std::vector<uint8_t> frames;
+    std::vector<uint16_t> decoded;
+
+    KernelContext(hid_device* device, size_t length)
+        : handle(device),
+          uniform(ChainLayout::uniform(PotFamily::AD5270, length)),
+          mixed(mixedLayout(length)),
+          values(length),
+          frames(uniform.frameLength(), 0x00),
+          decoded(length) {
+        for (size_t i = 0; i < length; ++i) {
+            values[i] = static_cast<uint16_t>((i * 37) & 0xFF);
+        }
+        if (mixed.frameLength() != uniform.frameLength()) {
+            throw std::runtime_error("Erreur : trames de longueurs différentes entre les chaînes mesurées.");
+        }
+    }
+
+    static ChainLayout mixedLayout(size_t length) {
+        static const PotFamily FAMILIES[] = {PotFamily::AD5270, PotFamily::AD5271, PotFamily::MCP42010};
+        std::vector<PotFamily> parts(length);
+        for (size_t i = 0; i < length; ++i) parts[i] = FAMILIES[i % 3];
+        return ChainLayout(parts);
+    }
+};
+
+typedef void (*KernelFunction)(KernelContext& context);
+
+// Codage par les traits résolus à la compilation (chemin des chaînes uniformes)
+static void encodeTraits(KernelContext& context) {
+    size_t length = context.values.size();
+    for (size_t i = 0; i < length; ++i) {
+        DefaultPotTraits::encodeWrite(context.values[i], &context.frames[i * DefaultPotTraits::frameBytes]);
+    }
+    clobberMemory();
+}
+
+static void encodeLayout(KernelContext& context) {
+    context.uniform.encodeWrite(context.values.data(), context.frames.data());
+    clobberMemory();
+}
+
+static void encodeMixed(KernelContext& context) {
+    context.mixed.encodeWrite(context.values.data(), context.frames.data());
+    clobberMemory();
+}
+
+static void decodeLayout(KernelContext& context) {
+    context.uniform.decodeValues(context.frames.data(), context.decoded.data());
+    clobberMemory();
+}
+
+// Construction des rapports : memset + recopie + appel du transport, par tranche de 60 octets
+static void reportBuild(KernelContext& context) {
+    size_t total = context.uniform.frameLength();
+    for (size_t offset = 0; offset < total; offset += 60) {
+        int chunk = static_cast<int>(total - offset < 60 ? total - offset : 60);
+        SPIDataTransferStatusDef def = SPIDataTransfer(context.handle, &context.frames[offset], chunk);
+        doNotOptimize(def.ErrorCode);
+    }
+}
+
+static void sendReceive(KernelContext& context) {
+    size_t total = context.uniform.frameLength();
+    for (size_t offset = 0; offset < total; offset += 60) {
+        int chunk = static_cast<int>(total - offset < 60 ? total - offset : 60);
+        SPIDataTransferStatusDef def = SPISendReceive(context.handle, &context.frames[offset], chunk, 0);
+        doNotOptimize(def.NumberOfBytesReceived);
+    }
+}
+
+// Copies de la structure de statut telles que faites par SPISendReceive (une par rapport)
+static void statusCopy(KernelContext& context) {
+    size_t total = context.uniform.frameLength();
+    SPIDataTransferStatusDef source;
+    std::memset(&source, 0, sizeof(source));
+    doNotOptimize(source);
+    for (size_t offset = 0; offset < total; offset += 60) {
+        SPIDataTransferStatusDef copy = source;
+        doNotOptimize(copy);
+    }
+}
+
+struct Kernel {
+    const char* name;
+    KernelFunction function;
+};
+
+static const Kernel KERNELS[] = {
+    {"encode-traits", encodeTraits},
+    {"encode-layout", encodeLayout},
+    {"encode-mixed", encodeMixed},
+    {"decode-layout", decodeLayout},
+    {"report-build", reportBuild},
+    {"send-receive", sendReceive},
+    {"status-copy", statusCopy},
+};
+
+static double elapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Double le nombre d'itérations jusqu'à dépasser la durée minimale, puis garde
+// la meilleure de plusieurs répétitions (la moins perturbée par l'ordonnanceur)
+static MicroResult runKernel(const Kernel& kernel, KernelContext& context, double minNs) {
+    unsigned long iterations = 1;
+    for (;;) {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned long i = 0; i < iterations; ++i) kernel.function(context);
+        if (elapsedNs(start) >= minNs) break;
+        iterations *= 2;
+    }
+
+    double best = 0.0;
+    for (int r = 0; r < MICRO_BENCH_REPETITIONS; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned long i = 0; i < iterations; ++i) kernel.function(context);
+        double perOp = elapsedNs(start) / iterations;
+        if (r == 0 || perOp < best) best = perOp;
+    }
+
+    MicroResult result;
+    result.kernel = kernel.name;
+    result.chainLength = context.uniform.length();
+    result.bytes = context.uniform.frameLength();
+    result.nsPerOp = best;
+    result.iterations = iterations;
+    return result;
+}
+
+static void writeJson(std::ostream& out, const std::vector<MicroResult>& results) {
+    out << "{\n  \"transport\": \"null\",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const MicroResult& r = results[i];
+        out << "    {\"kernel\": \"" << r.kernel << "\", \"chain_length\": " << r.chainLength
+            << ", \"bytes\": " << r.bytes << ", \"ns_per_op\": " << std::fixed << std::setprecision(2) << r.nsPerOp
+            << ", \"iterations\": " << r.iterations << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    std::string jsonPath;
+    double minMs = 20.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--min-ms" && i + 1 < argc) {
+            minMs = std::stod(argv[++i]);
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            std::cerr << "Usage : " << argv[0] << " [--filter <noyau>] [--min-ms <durée>] [--json <fichier|->]" << std::endl;
+            return 1;
+        }
+    }
+
+    SetMCP2210VirtualDevice(nullTransport, nullptr);
+    hid_device* handle = InitMCP2210();
+
+    std::vector<MicroResult> results;
+    for (const Kernel& kernel : KERNELS) {
+        if (!filter.empty() && filter != kernel.name) continue;
+        for (size_t length : CHAIN_LENGTHS) {
+            KernelContext context(handle, length);
+            context.uniform.encodeWrite(context.values.data(), context.frames.data());
+            results.push_back(runKernel(kernel, context, minMs * 1e6));
+        }
+    }
+
+    ReleaseMCP2210(handle);
+    SetMCP2210VirtualDevice(nullptr, nullptr);
+
+    std::ostream& table = jsonPath == "-" ? std::cerr : std::cout;
+    table << std::left << std::setw(16) << "noyau" << std::right << std::setw(8) << "pots" << std::setw(8) << "octets"
+          << std::setw(12) << "ns/op" << std::setw(12) << "ns/pot" << std::endl;
+    for (const MicroResult& r : results) {
+        table << std::left << std::setw(16) << r.kernel << std::right << std::setw(8) << r.chainLength
+              << std::setw(8) << r.bytes << std::fixed << std::setprecision(1) << std::setw(12) << r.nsPerOp
+              << std::setw(12) << r.nsPerOp / r.chainLength << std::endl;
+    }
+
+    if (jsonPath == "-") {
+        writeJson(std::cout, results);
+    } else if (!jsonPath.empty()) {
+        std::ofstream out(jsonPath);
+        if (!out) {
+            std::cerr << "Erreur : impossible d'écrire " << jsonPath << std::endl;
+            return 1;
+        }
+        writeJson(out, results);
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef ADAPTER_LOCK_H
+#define ADAPTER_LOCK_H
+
+#include <string>
+#include <chrono>
+#include "LatencyRecorder.h"
+
+// Verrou consultatif inter-processus par adaptateur (fichier verrouillé par flock/LockFileEx).
+// Il est pris pour une transaction à la fois, jamais pour toute la session.
+class AdapterLock {
+public:
+    AdapterLock(const std::string& serial, std::chrono::milliseconds timeout);
+    ~AdapterLock();
+    AdapterLock(const AdapterLock&) = delete;
+    AdapterLock& operator=(const AdapterLock&) = delete;
+
+    void acquire();
+    bool tryAcquire(); // false si le délai expire, sans exception
+    void release();
+
+    const LatencyRecorder& waitTimes() const;  // Attente avant obtention (us)
+    const LatencyRecorder& holdTimes() const;  // Durée de détention (us)
+
+    // $XDG_RUNTIME_DIR, sinon un répertoire 0700 propre à l'utilisateur sous /tmp
+    static std::string lockPath(const std::string& serial);
+
+private:
+#ifdef _WIN32
+    void* file;
+#else
+    int fd;
+#endif
+    std::chrono::milliseconds timeout;
+    bool held;
+    std::chrono::steady_clock::time_point acquiredAt;
+    LatencyRecorder waits;
+    LatencyRecorder holds;
+
+    bool tryLock();
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <functional>
+#include "PotentiometerManager.h"
+#include "LatencyRecorder.h"
+
+#define BENCH_GPIO_PIN 0x020       // GP5, basculé par la charge gpio-toggle
+#define BENCH_MAX_CHAIN_LENGTHS 6  // Une broche CS libre par longueur balayée
+
+struct BenchResult {
+    std::string workload;
+    unsigned int bitRate;
+    size_t chainLength;
+    LatencyRecorder latency; // us
+    double opsPerSecond;
+};
+
+// Charges de travail fixes, répétées pour chaque débit SPI, puis balayage de la longueur de chaîne
+class Benchmark {
+public:
+    Benchmark(PotentiometerManager& manager, unsigned int iterations);
+
+    void run(const std::vector<unsigned int>& bitRates, const std::vector<size_t>& chainLengths);
+
+    const std::vector<BenchResult>& results() const;
+    void printSummary(std::ostream& out) const;
+    void writeJson(std::ostream& out, const std::string& target) const;
+
+private:
+    PotentiometerManager& manager;
+    unsigned int iterations;
+    std::vector<BenchResult> benchResults;
+
+    void measure(const std::string& workload, unsigned int bitRate, size_t chainLength,
+                 const std::function<void(unsigned int)>& operation);
+};
+
+#endif
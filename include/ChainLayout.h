@@ -0,0 +1,123 @@
+#ifndef CHAIN_LAYOUT_H
+#define CHAIN_LAYOUT_H
+
+#include <vector>
+#include <string>
+#include <utility>
+#include "PotTraits.h"
+
+// Disposition fixée à la compilation : une classe de traits par position, dans l'ordre des
+// trames envoyées. Décalages calculés à la compilation, codage déroulé sans indirection.
+template <typename... Traits>
+class StaticChainLayout {
+public:
+    static constexpr size_t length = sizeof...(Traits);
+    static constexpr size_t frameLength = (Traits::frameBytes + ... + 0);
+
+    static bool valuesInRange(const uint16_t* values) {
+        return inRange(values, std::index_sequence_for<Traits...>());
+    }
+    static void encodeWrite(const uint16_t* values, uint8_t* frames) {
+        encodeWriteAt(values, frames, std::index_sequence_for<Traits...>());
+    }
+    static void decodeValues(const uint8_t* frames, uint16_t* values) {
+        decodeValuesAt(frames, values, std::index_sequence_for<Traits...>());
+    }
+    static void encodeRead(uint8_t* frames) {
+        encodeReadAt(frames, std::index_sequence_for<Traits...>());
+    }
+    static void encodeStore(uint8_t* frames) {
+        encodeStoreAt(frames, std::index_sequence_for<Traits...>());
+    }
+
+private:
+    static constexpr size_t offset(size_t position) {
+        constexpr size_t bytes[] = {Traits::frameBytes..., 0};
+        size_t total = 0;
+        for (size_t i = 0; i < position; ++i) total += bytes[i];
+        return total;
+    }
+
+    template <size_t... I>
+    static bool inRange(const uint16_t* values, std::index_sequence<I...>) {
+        return ((values[I] <= Traits::maxValue) && ... && true);
+    }
+    template <size_t... I>
+    static void encodeWriteAt(const uint16_t* values, uint8_t* frames, std::index_sequence<I...>) {
+        (Traits::encodeWrite(values[I], frames + offset(I)), ...);
+    }
+    template <size_t... I>
+    static void decodeValuesAt(const uint8_t* frames, uint16_t* values, std::index_sequence<I...>) {
+        ((values[I] = Traits::decodeValue(frames + offset(I))), ...);
+    }
+    template <size_t... I>
+    static void encodeReadAt(uint8_t* frames, std::index_sequence<I...>) {
+        (Traits::encodeRead(frames + offset(I)), ...);
+    }
+    template <size_t... I>
+    static void encodeStoreAt(uint8_t* frames, std::index_sequence<I...>) {
+        (Traits::encodeStore(frames + offset(I)), ...);
+    }
+};
+
+template <typename Traits, typename Positions>
+struct RepeatedChainLayout;
+
+template <typename Traits, size_t... I>
+struct RepeatedChainLayout<Traits, std::index_sequence<I...>> {
+    template <size_t>
+    using Same = Traits;
+    typedef StaticChainLayout<Same<I>...> type;
+};
+
+// Chaîne de Length potentiomètres d'une même famille
+template <typename Traits, size_t Length>
+using UniformChainLayout = typename RepeatedChainLayout<Traits, std::make_index_sequence<Length>>::type;
+
+// Caractéristiques d'une famille connues à l'exécution (noms, limites) ; le codage
+// reste dans PotTraits
+struct PotFamilyInfo {
+    const char* name;
+    size_t frameBytes;
+    uint16_t maxValue;
+    bool hasOtp;
+    bool hasReadback;
+};
+
+const PotFamilyInfo& potFamilyInfo(PotFamily family);
+PotFamily parsePotFamily(const std::string& name);
+
+// Disposition choisie à l'exécution (chaînes décrites en ligne de commande). Les positions
+// consécutives d'une même famille forment un segment codé par la boucle de ses traits :
+// une seule sélection de famille par segment, aucune par potentiomètre.
+class ChainLayout {
+public:
+    ChainLayout();
+    explicit ChainLayout(const std::vector<PotFamily>& parts);
+    static ChainLayout uniform(PotFamily family, size_t length);
+
+    size_t length() const;
+    size_t frameLength() const; // Octets d'une trame de chaîne
+    PotFamily family(size_t position) const;
+    const PotFamilyInfo& info(size_t position) const;
+
+    void checkValues(const std::vector<uint16_t>& values) const;
+    void encodeWrite(const uint16_t* values, uint8_t* frames) const;
+    void decodeValues(const uint8_t* frames, uint16_t* values) const;
+    void encodeRead(uint8_t* frames) const;  // NOP pour les familles sans relecture
+    void encodeStore(uint8_t* frames) const; // NOP pour les familles sans mémoire
+
+private:
+    struct Segment {
+        PotFamily family;
+        size_t first;   // Première position
+        size_t count;
+        size_t offset;  // Premier octet dans la trame
+    };
+
+    std::vector<PotFamily> parts;
+    std::vector<Segment> segments;
+    size_t totalLength;
+};
+
+#endif
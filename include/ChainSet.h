@@ -0,0 +1,81 @@
+#ifndef CHAIN_SET_H
+#define CHAIN_SET_H
+
+#include <vector>
+#include <chrono>
+#include "MCP2210Interface.h"
+#include "ChainLayout.h"
+
+class StatePublisher;
+
+#define MAX_CHAIN_LENGTH 30       // 2 octets par potentiomètre, 60 octets par rapport SPI
+#define MAX_CHAIN_FRAME_LENGTH 60 // Octets SPI d'une trame de chaîne, toutes familles confondues
+
+struct ChainSetStats {
+    unsigned long updates;          // Mises à jour de chaînes envoyées
+    unsigned long settingsWrites;   // Changements de CS effectivement envoyés
+    unsigned long settingsSkipped;  // Changements évités (même chaîne que le transfert précédent)
+    double updatesPerSecond;        // Débit cumulé sur toutes les chaînes
+};
+
+// Plusieurs chaînes de potentiomètres sur un même MCP2210, chacune sur ses broches CS.
+// Les paramètres CS écrits restent ceux de la dernière chaîne servie : ils ne sont réécrits
+// que pour une autre chaîne. Les CS et la taille de transfert de la chaîne principale, relus
+// au premier transfert, sont rétablis juste avant son prochain transfert.
+class ChainSet {
+public:
+    explicit ChainSet(MCP2210Interface& mcpInterface);
+    ~ChainSet();
+    ChainSet(const ChainSet&) = delete;
+    ChainSet& operator=(const ChainSet&) = delete;
+
+    size_t addChain(uint16_t csMask, size_t length);                 // Chaîne de la famille par défaut
+    size_t addChain(uint16_t csMask, const ChainLayout& layout);     // Familles mélangées
+    size_t size() const;
+    void clear(); // Retire toutes les chaînes, après avoir rétabli la chaîne principale
+
+    void stage(size_t chain, const std::vector<uint16_t>& values);
+    void commit();
+    void program(size_t chain, const std::vector<uint16_t>& values);
+
+    const std::vector<uint16_t>& shadow(size_t chain) const;
+    ChainSetStats stats() const;
+
+    // Chaîne k publiée en position k + 1 du segment partagé (0 : chaîne principale)
+    void setStatePublisher(StatePublisher* publisher);
+
+    // Rétablit les paramètres de la chaîne principale, avant de les lire ou de les modifier
+    void selectMain();
+
+    // Paramètres SPI modifiés hors du ChainSet : relus avant le prochain transfert
+    void invalidateSettings();
+
+private:
+    struct Chain {
+        uint16_t csMask;
+        ChainLayout layout;
+        std::vector<uint16_t> shadow;   // Dernières valeurs envoyées
+        std::vector<uint16_t> pending;  // Valeurs en attente de commit()
+        bool dirty;
+    };
+
+    MCP2210Interface& mcpInterface;
+    std::vector<Chain> chains;
+    SPITransferSettingsDef settings;      // Paramètres actuellement écrits dans le MCP2210
+    SPITransferSettingsDef mainSettings;  // Paramètres de la chaîne principale, à rétablir
+    bool settingsLoaded;
+    bool settingsStale;                   // Écriture interrompue : contenu du MCP2210 inconnu
+    bool transferring;                    // Transfert d'une chaîne du ChainSet en cours
+    unsigned long settingsGeneration;
+    uint16_t allChipSelects;
+
+    ChainSetStats counters;
+    StatePublisher* statePublisher;
+    std::chrono::steady_clock::time_point firstUpdate;
+
+    void select(const Chain& chain);
+    bool apply(const SPITransferSettingsDef& next);
+    void send(Chain& chain);
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef COMMAND_SCHEDULER_H
+#define COMMAND_SCHEDULER_H
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <future>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "LatencyRecorder.h"
+
+// Files de priorité devant le MCP2210, de la plus prioritaire à la moins prioritaire
+enum class Lane {
+    RealTime = 0,    // Écritures des curseurs
+    Interactive = 1, // Lectures demandées par l'utilisateur
+    Bulk = 2         // Travaux de fond (dump EEPROM, sondages d'état)
+};
+
+#define LANE_COUNT 3
+
+struct LaneStats {
+    unsigned long completed;
+    unsigned long deadlineMisses;
+    unsigned long steps;      // Étapes exécutées (un rapport USB par étape)
+    LatencyRecorder latency;  // Soumission -> fin du travail, en microsecondes
+};
+
+// Ordonnanceur à un seul thread : la file la plus prioritaire passe d'abord, et au sein
+// d'une file l'échéance la plus proche. Un travail est découpé en étapes d'un rapport
+// USB ; entre deux étapes un travail plus urgent peut passer devant (préemption).
+class CommandScheduler {
+public:
+    // Une étape retourne true quand le travail est terminé
+    typedef std::function<bool()> Step;
+
+    CommandScheduler();
+    ~CommandScheduler();
+    CommandScheduler(const CommandScheduler&) = delete;
+    CommandScheduler& operator=(const CommandScheduler&) = delete;
+
+    std::future<void> submit(Lane lane, std::chrono::microseconds deadline, Step step);
+    std::future<void> submitOnce(Lane lane, std::chrono::microseconds deadline, std::function<void()> action);
+
+    void drain();
+    LaneStats stats(Lane lane) const;
+
+private:
+    struct Job {
+        Lane lane;
+        std::chrono::steady_clock::time_point submitted;
+        std::chrono::steady_clock::time_point deadline;
+        Step step;
+        std::promise<void> done;
+    };
+
+    std::vector<std::unique_ptr<Job>> lanes[LANE_COUNT];
+    LaneStats laneStats[LANE_COUNT];
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable idle;
+    bool running;
+    bool busy;
+    std::thread worker;
+
+    void run();
+    bool pickJob(size_t& lane, size_t& index) const;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef CROSSFADE_H
+#define CROSSFADE_H
+
+#include <vector>
+#include "MCP2210Interface.h"
+
+enum class TaperMode {
+    Linear,      // Interpolation linéaire des valeurs RDAC
+    Logarithmic  // Progression géométrique (courbe "audio")
+};
+
+// Statistiques d'un envoi cadencé de trames
+struct StreamStats {
+    size_t framesDelivered;
+    size_t framesLate;        // Trames envoyées après leur échéance
+    double elapsedSeconds;
+    double updatesPerSecond;  // Débit réellement obtenu
+};
+
+// Calcule en une passe toutes les trames intermédiaires entre deux états de la chaîne
+class Crossfade {
+public:
+    Crossfade(const std::vector<uint16_t>& from, const std::vector<uint16_t>& to, size_t steps, TaperMode mode);
+
+    size_t steps() const;
+    const uint8_t* frames(size_t step) const;
+    const uint8_t* data() const;
+
+private:
+    size_t stepCount;
+    std::vector<uint8_t> frameArena; // stepCount * CHAIN_TRANSFER_LENGTH octets
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef DEVICE_PATH_CACHE_H
+#define DEVICE_PATH_CACHE_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#define DEVICE_PATH_CACHE_FILE "mcp2210_device_path.txt"
+
+// Dernier chemin de périphérique (/dev/hidrawN, chemin Windows) connu par numéro
+// de série d'adaptateur, pour rouvrir sans énumérer les périphériques HID
+class DevicePathCache {
+public:
+    explicit DevicePathCache(const std::string& path = DEVICE_PATH_CACHE_FILE);
+
+    std::string lookup(const std::string& serial) const; // Vide si inconnu
+    std::string lastSerial() const;                      // Adaptateur ouvert le plus récemment
+    void remember(const std::string& serial, const std::string& devicePath);
+    void save() const;
+
+private:
+    std::string path;
+    std::vector<std::pair<std::string, std::string>> entries; // Du plus ancien au plus récent
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef EXPECTED_H
+#define EXPECTED_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+// Catégorie d'échec d'une opération sur l'adaptateur
+enum class ErrorKind : uint8_t {
+    None,
+    Disconnected,     // Pas de handle : adaptateur débranché ou non rouvert
+    UsbError,         // hid_write/hid_read en échec (code négatif de mcp2210.cpp)
+    DeviceStatus,     // Octet d'état du MCP2210 non nul (0xF7 bus indisponible, 0xF8 transfert en cours)
+    ShortResponse,    // Moins d'octets reçus que d'octets envoyés
+    FrameTooLong,     // Trames plus longues qu'un rapport SPI
+    InvalidArgument,  // Nombre de valeurs différent de la longueur de la chaîne
+    AdapterBusy,      // Verrou inter-processus non obtenu dans le délai
+    ExternalMaster,   // Bus SPI gardé par un maître externe au-delà du délai
+    Timeout           // Transfert SPI non terminé dans le délai ou le nombre de sondages
+};
+
+// Erreur structurée, copiable sans allocation : le message est une chaîne statique,
+// les détails matériels restent sous forme numérique
+struct ErrorCode {
+    ErrorKind kind;
+    const char* message;  // Message français statique, sans préfixe de contexte
+    int libraryCode;      // Retour de mcp2210.cpp (<0 : erreur USB, >0 : octet d'état)
+    uint8_t deviceStatus; // Octet d'état du MCP2210 au moment de l'échec
+    uint8_t engineStatus; // Dernier état du moteur SPI (0x10, 0x20, 0x30), 0 si inconnu
+
+    ErrorCode() : kind(ErrorKind::None), message(""), libraryCode(0), deviceStatus(0), engineStatus(0) {}
+    ErrorCode(ErrorKind kind, const char* message, int libraryCode = 0, uint8_t engineStatus = 0)
+        : kind(kind), message(message), libraryCode(libraryCode),
+          deviceStatus(libraryCode > 0 ? static_cast<uint8_t>(libraryCode) : 0), engineStatus(engineStatus) {}
+
+    // Code retourné par une fonction de mcp2210.cpp : erreur USB ou octet d'état
+    static ErrorCode fromLibrary(int code, const char* message, uint8_t engineStatus = 0) {
+        return ErrorCode(code < 0 ? ErrorKind::UsbError : ErrorKind::DeviceStatus, message, code, engineStatus);
+    }
+
+    bool ok() const { return kind == ErrorKind::None; }
+    std::string describe() const; // Message et détails matériels (chemin d'exception uniquement)
+};
+
+template <typename E>
+struct Unexpected {
+    E error;
+};
+
+template <typename E>
+Unexpected<E> unexpected(E error) {
+    return Unexpected<E>{error};
+}
+
+[[noreturn]] void throwError(const ErrorCode& error);
+
+// Valeur ou erreur, à la manière de std::expected (C++23). Le chemin d'erreur
+// n'alloue rien ; valueOrThrow() sert d'adaptateur vers l'API à exceptions.
+template <typename T, typename E = ErrorCode>
+class Expected {
+public:
+    Expected(const T& value) : storedValue(value) {}
+    Expected(T&& value) : storedValue(std::move(value)) {}
+    Expected(const Unexpected<E>& error) : storedError(error.error) {}
+
+    bool hasValue() const { return storedValue.has_value(); }
+    explicit operator bool() const { return hasValue(); }
+
+    T& value() { return *storedValue; }             // Précondition : hasValue()
+    const T& value() const { return *storedValue; }
+    const E& error() const { return storedError; }   // Précondition : !hasValue()
+
+    T& valueOrThrow() & {
+        if (!storedValue) throwError(storedError);
+        return *storedValue;
+    }
+
+    T valueOrThrow() && {
+        if (!storedValue) throwError(storedError);
+        return std::move(*storedValue);
+    }
+
+private:
+    std::optional<T> storedValue;
+    E storedError;
+};
+
+template <typename E>
+class Expected<void, E> {
+public:
+    Expected() : failed(false) {}
+    Expected(const Unexpected<E>& error) : failed(true), storedError(error.error) {}
+
+    bool hasValue() const { return !failed; }
+    explicit operator bool() const { return hasValue(); }
+
+    const E& error() const { return storedError; }
+
+    void valueOrThrow() const {
+        if (failed) throwError(storedError);
+    }
+
+private:
+    bool failed;
+    E storedError;
+};
+
+#endif
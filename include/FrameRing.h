@@ -0,0 +1,42 @@
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "MCP2210Interface.h"
+
+#define FRAME_RING_DEFAULT_DEPTH 64
+
+// File bornée de trames de chaîne entre un producteur et un consommateur.
+// Les emplacements sont réutilisés sans allocation ; un producteur trop rapide est bloqué (contre-pression).
+class FrameRing {
+public:
+    explicit FrameRing(size_t depth = FRAME_RING_DEFAULT_DEPTH, size_t frameLength = CHAIN_TRANSFER_LENGTH);
+
+    uint8_t* acquireSlot();       // Attend un emplacement libre ; nullptr si la file est fermée
+    void publishSlot();
+    const uint8_t* front();       // Attend une trame ; nullptr si la file est fermée et vide
+    void releaseFront();
+    void close();
+
+    unsigned long producerStalls() const; // Attentes du producteur sur file pleine
+    unsigned long consumerStalls() const; // Attentes du consommateur sur file vide
+
+private:
+    std::vector<uint8_t> slots;
+    size_t depth;
+    size_t frameLength;
+    size_t head;   // Prochaine trame à consommer
+    size_t count;
+    bool closed;
+    unsigned long fullWaits;
+    unsigned long emptyWaits;
+
+    mutable std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+};
+
+#endif
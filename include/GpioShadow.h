@@ -0,0 +1,37 @@
+#ifndef GPIO_SHADOW_H
+#define GPIO_SHADOW_H
+
+#include "MCP2210Interface.h"
+
+// Copie locale des 9 GPIO (bit n = GPn). Les modifications sont regroupées
+// et envoyées en une seule commande USB par flush().
+class GpioShadow {
+public:
+    explicit GpioShadow(MCP2210Interface& mcpInterface);
+
+    void sync();
+    void setPins(uint16_t mask, uint16_t values);
+    void togglePins(uint16_t mask);
+    void setDirections(uint16_t mask, uint16_t inputs);
+    uint16_t readPins(uint16_t mask = GPIO_PIN_MASK);
+    void flush();
+
+    unsigned long commandsSent() const;
+    unsigned long changesMerged() const;
+
+private:
+    MCP2210Interface& mcpInterface;
+    uint16_t values;
+    uint16_t directions;  // 1 : entrée, 0 : sortie
+    bool synced;
+    unsigned long syncedGeneration; // Une reconnexion remet les GPIO à leur état de démarrage
+    bool valuesDirty;
+    bool directionsDirty;
+    unsigned long pendingChanges;
+    unsigned long sentCount;
+    unsigned long mergedCount;
+
+    void ensureSynced();
+};
+
+#endif
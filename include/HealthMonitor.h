@@ -0,0 +1,45 @@
+#ifndef HEALTH_MONITOR_H
+#define HEALTH_MONITOR_H
+
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "PotentiometerManager.h"
+#include "LatencyRecorder.h"
+#include "CommandScheduler.h"
+
+// Surveillance de l'adaptateur en tâche de fond : détection des déconnexions,
+// réouverture par numéro de série et rejeu de l'état de la chaîne. Avec un
+// ordonnanceur, sondages et reconnexions passent par sa file de fond.
+class HealthMonitor {
+public:
+    HealthMonitor(PotentiometerManager& manager, std::chrono::milliseconds period, CommandScheduler* scheduler = nullptr);
+    ~HealthMonitor();
+    HealthMonitor(const HealthMonitor&) = delete;
+    HealthMonitor& operator=(const HealthMonitor&) = delete;
+
+    void start();
+    void stop();
+
+    unsigned long recoveries() const;
+    LatencyRecorder downtimes() const; // Durée de chaque interruption, en microsecondes
+
+private:
+    PotentiometerManager& manager;
+    std::chrono::milliseconds period;
+    CommandScheduler* scheduler;
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable wakeUp;
+    bool running;
+    unsigned long recoveryCount;
+    LatencyRecorder downtimeSamples;
+
+    void run();
+    bool waitPeriod();
+    bool probe();
+    void reconnect();
+};
+
+#endif
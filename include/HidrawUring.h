@@ -0,0 +1,107 @@
+#ifndef HIDRAW_URING_H
+#define HIDRAW_URING_H
+
+#ifdef __linux__
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include "mcp2210.h"
+
+#define HIDRAW_URING_SQES_PER_DEVICE 3 // Écriture, lecture liée, délai lié
+
+enum class HidrawBackend {
+    Uring,    // Un io_uring_enter par tour pour tous les adaptateurs
+    Blocking  // write, poll, read par adaptateur, comme hid.c
+};
+
+// Issue du transfert SPI d'un adaptateur du lot
+struct HidrawTransferResult {
+    int status;            // 0, code négatif de mcp2210.h ou octet d'état du MCP2210
+    uint8_t engineStatus;  // Dernier état du moteur SPI
+    unsigned int polls;    // Réponses du moteur (0x20/0x30), comptées comme SPISendReceiveBounded
+    unsigned int busyReplies;
+    bool cancelled;
+};
+
+// Échanges de rapports avec plusieurs MCP2210 depuis un seul thread. Chaque tour
+// soumet, pour tous les adaptateurs actifs, l'écriture du rapport suivie de la
+// lecture de la réponse (liées, tampons enregistrés), puis récolte toutes les
+// complétions en un seul appel. Sans io_uring utilisable (noyau < 5.6, io_uring
+// désactivé, mémoire verrouillable insuffisante), repli sur write/poll/read.
+class HidrawUring {
+public:
+    explicit HidrawUring(size_t maxDevices, HidrawBackend preferred = HidrawBackend::Uring,
+                         std::chrono::milliseconds reportTimeout = std::chrono::milliseconds(1000));
+    ~HidrawUring();
+    HidrawUring(const HidrawUring&) = delete;
+    HidrawUring& operator=(const HidrawUring&) = delete;
+
+    size_t openDevice(const std::string& path); // /dev/hidrawN, ouvert non bloquant
+    size_t adoptDevice(int fd);                 // Descripteur fourni par l'appelant, fermé par le lot
+    size_t deviceCount() const;
+
+    HidrawBackend backend() const;
+    const std::string& fallbackReason() const;  // Cause du repli, vide sinon
+
+    // Transfert SPI complet sur chaque adaptateur : data[i] est envoyé à l'adaptateur i
+    // puis remplacé par les octets reçus. Sondages vides par tours jusqu'à la fin de tous
+    // les transferts ; limites et annulation de la politique, comptées par SPITransferAccountReply
+    // comme pour SPISendReceiveBounded (délai mesuré depuis le début du lot).
+    void spiTransfer(uint8_t* const* data, size_t length, std::vector<HidrawTransferResult>& results,
+                     const SPITransferPolicyDef& policy = DefaultSPITransferPolicy());
+
+    unsigned long syscalls() const; // Appels système émis par les échanges (hors ouverture)
+    unsigned long rounds() const;
+
+private:
+    std::vector<int> fds;
+    size_t capacity;
+    HidrawBackend activeBackend;
+    std::string reason;
+    std::chrono::milliseconds timeout;
+    unsigned long syscallCount;
+    unsigned long roundCount;
+
+    // Rapports : un emplacement d'envoi et un de réception par adaptateur, enregistrés d'un bloc
+    uint8_t* arena;
+    size_t arenaBytes;
+
+    // Anneaux io_uring (appels système bruts, sans liburing)
+    int ringFd;
+    void* sqRing;
+    size_t sqRingBytes;
+    void* cqRing;
+    size_t cqRingBytes;
+    struct io_uring_sqe* sqes;
+    size_t sqesBytes;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    struct io_uring_cqe* cqes;
+    size_t registeredFiles; // Descripteurs enregistrés (IOSQE_FIXED_FILE)
+    struct __kernel_timespec reportTimespec;
+
+    uint8_t* command(size_t device);
+    uint8_t* response(size_t device);
+    size_t addDevice(int fd);
+
+    bool setupRing(size_t maxDevices);
+    void teardownRing();
+    int enter(unsigned toSubmit, unsigned minComplete);
+
+    // Un rapport vers chaque adaptateur actif ; statuses[k] reçoit l'octet d'état ou un code négatif
+    void exchange(const std::vector<size_t>& active, std::vector<int>& statuses);
+    void exchangeUring(const std::vector<size_t>& active, std::vector<int>& statuses);
+    void exchangeBlocking(const std::vector<size_t>& active, std::vector<int>& statuses);
+};
+
+#endif
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef LATENCY_RECORDER_H
+#define LATENCY_RECORDER_H
+
+#include <vector>
+#include <cstddef>
+
+#define LATENCY_RECORDER_WINDOW 8192 // Échantillons conservés pour les centiles
+
+// Échantillons de latence (en microsecondes) et calcul de la distribution.
+// Mémoire bornée : nombre, moyenne, minimum et maximum portent sur tous les
+// échantillons, les centiles sur les LATENCY_RECORDER_WINDOW plus récents.
+class LatencyRecorder {
+public:
+    LatencyRecorder();
+
+    void add(double micros);
+    void clear();
+
+    size_t count() const;
+    double mean() const;
+    double min() const;
+    double max() const;
+    double percentile(double p) const; // p entre 0 et 100
+
+private:
+    std::vector<double> window;          // Anneau des échantillons récents
+    size_t next;                         // Prochaine case écrite une fois l'anneau plein
+    mutable std::vector<double> sorted;  // Copie triée de l'anneau, refaite après un ajout
+    mutable bool sortedValid;
+    size_t total;
+    double sum;
+    double lowest;
+    double highest;
+
+    void sortSamples() const;
+};
+
+#endif
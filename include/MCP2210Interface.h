@@ -2,23 +2,161 @@
 #define MCP2210_INTERFACE_H
 
 #include <vector>
+#include <bitset>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <new>
 #include "mcp2210.h"
+#include "Expected.h"
+#include "AdapterLock.h"
+#include "ChainLayout.h"
 
 #define NUM_POTS 10
+#define CHAIN_FRAME_LENGTH (NUM_POTS * 2)        // Une trame de 2 octets par potentiomètre
+#define CHAIN_TRANSFER_LENGTH (NUM_POTS * 2 * 2) // Trames + trames vides pour récupérer les réponses
+#define RDAC_VALUE_MASK 0x03FF                   // Valeur RDAC sur 10 bits
+
+// Chaîne principale : codage résolu à la compilation
+typedef UniformChainLayout<DefaultPotTraits, NUM_POTS> MainChainLayout;
+
+// Coût de démarrage, mesuré depuis la construction de l'interface
+struct OpenTiming {
+    bool cachedPath;            // Ouvert par le chemin mémorisé, sans énumération
+    std::string devicePath;     // Vide pour le simulateur
+    double openMicros;
+    double firstTransferMicros; // Négatif tant qu'aucun transfert SPI n'a abouti
+};
 
 class MCP2210Interface {
 public:
-    MCP2210Interface();
+    // pathCacheFile non vide : ouverture par le chemin mémorisé (DevicePathCache),
+    // énumération seulement si ce chemin n'est plus celui de l'adaptateur
+    explicit MCP2210Interface(const std::string& pathCacheFile = "");
     ~MCP2210Interface();
 
     std::vector<uint16_t> readCurrentResistances();
     std::vector<uint16_t> readMemoryResistances();
     void programResistances(const std::vector<uint16_t>& values);
     void storeResistancesToMemory();
+    void storeResistancesToMemory(const std::bitset<NUM_POTS>& pots);
+    std::bitset<NUM_POTS> programAndVerify(const std::vector<uint16_t>& values);
+
+    // Envoi de trames déjà encodées (longueur CHAIN_TRANSFER_LENGTH), sans allocation
+    void transferFrames(const uint8_t* frames, size_t length, uint8_t* responseFrames = nullptr);
+
+    // Variantes sans exception des opérations de chaîne, pour les boucles de reprise :
+    // l'erreur porte le code de mcp2210.cpp, l'octet d'état et l'état du moteur SPI.
+    // Les méthodes ci-dessus ne font que lever l'erreur retournée.
+    Expected<std::vector<uint16_t>> tryReadCurrentResistances();
+    Expected<std::vector<uint16_t>> tryReadMemoryResistances();
+    Expected<void> tryProgramResistances(const std::vector<uint16_t>& values);
+    Expected<void> tryStoreResistancesToMemory(const std::bitset<NUM_POTS>& pots);
+    Expected<std::bitset<NUM_POTS>> tryProgramAndVerify(const std::vector<uint16_t>& values);
+    Expected<void> tryTransferFrames(const uint8_t* frames, size_t length, uint8_t* responseFrames = nullptr);
+    Expected<ChipStatusDef> tryChipStatus();
+    std::string serialNumber();
+    OpenTiming openTiming() const;
+
+    // Appelé dans la transaction avant chaque transfert de la chaîne principale (le ChainSet y
+    // rétablit les CS et la taille de transfert de cette chaîne s'il les a changés)
+    void setMainChainSelector(std::function<void()> selector);
+
+    // Appelé après chaque transfert SPI réussi avec sa taille et son issue (durée, sondages), hors attente du verrou
+    void setTransferObserver(std::function<void(size_t, const SPITransferOutcomeDef&)> observer);
+
+    // Limites des transferts SPI (délai, sondages, attente sur bus occupé, annulation) ;
+    // std::invalid_argument si ni délai ni nombre de sondages ne sont limités
+    void setTransferPolicy(const SPITransferPolicyDef& policy);
+    SPITransferPolicyDef transferPolicy() const;
+    // Appelé après chaque transfert SPI, quelle qu'en soit l'issue, avec sa durée
+    void setOutcomeObserver(std::function<void(const SPITransferOutcomeDef&)> observer);
+    SPITransferOutcomeDef lastTransferOutcome() const;
+    unsigned int lastBusOwner() const; // SPI_BUS_OWNER_UNKNOWN tant qu'il n'a pas été relu
+
+    // Compteur d'événements de la broche d'interruption GP6
+    void configureTriggerPin(unsigned int countMode);
+    unsigned int readInterruptEvents(bool reset);
+
+    uint8_t readEeprom(uint8_t address);
+    ChipStatusDef chipStatus();
+
+    SPITransferSettingsDef readSpiSettings();
+    void writeSpiSettings(const SPITransferSettingsDef& settings);
+    void designateChipSelects(uint16_t csMask);
+
+    // Accès exclusif inter-processus, transaction par transaction
+    void enableArbitration(std::chrono::milliseconds timeout, bool externalMaster = false);
+    const AdapterLock* arbitration() const;
+
+    // Surveillance et reprise après déconnexion
+    bool probe();
+    bool faultDetected() const;
+    void reconnect();
+    unsigned long connectionGeneration() const;
+    void setReplayValues(const uint16_t* values);
+
+    // GPIO en masque de bits (bit n = GPn)
+    uint16_t readGpioValues();
+    void writeGpioValues(uint16_t bits);
+    uint16_t readGpioDirections();
+    void writeGpioDirections(uint16_t bits);
+
+    // NUM_POTS consignes dans la plage de la famille : le codage masque sans vérifier
+    static Expected<void> checkValues(const std::vector<uint16_t>& values);
+    static void encodeWriteFrames(const uint16_t* values, uint8_t* frames);
+    static void decodeWriteFrames(const uint8_t* frames, uint16_t* values);
+
+    // Portée d'une transaction : verrou de l'adaptateur et bus SPI disponible. Les transactions
+    // s'imbriquent ; seule la plus externe prend et rend le verrou inter-processus.
+    class Transaction {
+    public:
+        explicit Transaction(MCP2210Interface& owner);       // Lève l'erreur d'ouverture
+        Transaction(MCP2210Interface& owner, std::nothrow_t); // Erreur consultée par failure()
+        ~Transaction();
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+        const ErrorCode& failure() const;
+    private:
+        MCP2210Interface& owner;
+        std::lock_guard<std::recursive_mutex> deviceLock;
+        bool nested;
+        bool adapterLocked;
+        ErrorCode error;
+    };
 
 private:
     hid_device* handle;
-    void sendSPICommand(const std::vector<uint8_t>& commandFrames, std::vector<uint8_t>& responseFrames);
+    std::wstring serial;
+    std::string pathCacheFile;
+    std::chrono::steady_clock::time_point openStart;
+    OpenTiming timing;
+    std::recursive_mutex deviceMutex;           // Accès au périphérique depuis plusieurs threads
+    std::atomic<bool> faulted;
+    std::atomic<unsigned long> generation;      // Incrémenté à chaque reconnexion
+    bool spiSettingsKnown;
+    SPITransferSettingsDef spiSettings;          // Derniers paramètres SPI lus ou écrits
+    std::vector<uint16_t> lastProgrammed;        // État rejoué après une reconnexion
+    std::function<void(size_t, const SPITransferOutcomeDef&)> transferObserver;
+    std::function<void(const SPITransferOutcomeDef&)> outcomeObserver;
+    mutable std::mutex outcomeMutex;             // policy et lastOutcome, lus par d'autres threads pendant un transfert
+    SPITransferPolicyDef policy;
+    SPITransferOutcomeDef lastOutcome;
+    std::atomic<unsigned int> busOwner;
+    std::unique_ptr<AdapterLock> adapterLock;
+    bool externalMaster;
+    std::chrono::milliseconds arbitrationTimeout;
+    unsigned int transactionDepth;              // Transactions imbriquées dans ce thread (sous deviceMutex)
+    std::function<void()> mainChainSelector;
+
+    void openDevice();
+    ErrorCode waitForBus();
+    void releaseBusIfRequested();
+    Expected<void> sendSPICommand(const uint8_t* commandFrames, size_t length, uint8_t* responseFrames);
+    Expected<std::vector<uint16_t>> readChainFrames(uint8_t command);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef MCP2210_SIMULATOR_H
+#define MCP2210_SIMULATOR_H
+
+#include <vector>
+#include <map>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include "MCP2210Interface.h"
+#include "MCP2210Transport.h"
+
+// MCP2210 virtuel et sa chaîne de potentiomètres (famille par défaut), branché sous SendUSBCmd.
+// Une latence fixe par rapport USB et la durée SPI déduite du débit reproduisent le coût d'un adaptateur réel.
+class MCP2210Simulator {
+public:
+    explicit MCP2210Simulator(size_t potCount = NUM_POTS,
+                              std::chrono::microseconds reportLatency = std::chrono::microseconds(0));
+    ~MCP2210Simulator();
+    MCP2210Simulator(const MCP2210Simulator&) = delete;
+    MCP2210Simulator& operator=(const MCP2210Simulator&) = delete;
+
+    // Tant qu'il est installé, InitMCP2210() ouvre le simulateur au lieu d'un périphérique USB
+    void install();
+    void uninstall();
+
+    // Transport en mémoire du simulateur : à lier à une poignée (OpenMCP2210Transport) ou à envelopper
+    LoopbackTransport& transport();
+
+    void setReportLatency(std::chrono::microseconds latency);
+    void pulseInterrupt(unsigned int count = 1);
+    unsigned long reports() const;
+    std::vector<uint16_t> wipers() const;
+
+private:
+    struct SimulatedChain {
+        std::vector<uint16_t> rdac;
+        std::vector<uint16_t> memory;
+    };
+
+    std::vector<uint16_t> rdac;   // Chaîne principale
+    std::vector<uint16_t> memory;
+    std::map<unsigned int, SimulatedChain> otherChains; // Par CS sélectionnés
+    SPITransferSettingsDef spiSettings;
+    uint8_t designations[9];
+    uint16_t gpioValues;
+    uint16_t gpioDirections;
+    uint8_t eeprom[256];
+    unsigned int interruptEvents;
+
+    bool transferPending;
+    std::vector<uint8_t> pendingResponse;
+    double pendingSpiMicros;
+
+    std::chrono::microseconds latency;
+    std::atomic<unsigned long> reportCount;
+    bool installed;
+    LoopbackTransport loopback;
+    mutable std::mutex stateMutex;
+
+    static int handleReport(void* context, byte* cmdBuf, byte* responseBuf);
+    int handle(const byte* cmd, byte* rsp);
+    void shiftChain(const uint8_t* data, size_t length, uint8_t* response);
+    void wait(double micros) const;
+};
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef MCP2210_TRANSPORT_H
+#define MCP2210_TRANSPORT_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <cstdint>
+#include "mcp2210.h"
+
+#ifdef _WIN32
+#include <chrono>
+#include <thread>
+#endif
+
+#define MCP2210_REPORT_TIMEOUT_INFINITE -1
+#define MCP2210_LOOPBACK_DEPTH 4
+#define MCP2210_RECORDING_HEADER "# mcp2210-reports 1"
+
+// Transport de rapports : classe sans méthode virtuelle offrant
+//   int submit(const byte* report)             0, ou code négatif de mcp2210.h
+//   int receive(byte* report, int timeoutMs)   octets lus, 0 si rien dans le délai, ou code négatif
+//   int wait(int timeoutMs)                    1 si une réponse peut être lue, 0 à l'expiration, ou code négatif
+//   int fd() const                             descripteur à surveiller (boucle d'événements), -1 si aucun
+// Les rapports font COMMAND_BUFFER_LENGTH octets, les délais -1 attendent sans limite.
+
+// Aller-retour d'une commande, résolu à la compilation pour chaque transport
+template <typename Transport>
+inline int ExchangeReports(Transport& transport, byte* cmdBuf, byte* responseBuf) {
+    int r = transport.submit(cmdBuf);
+    if (r < 0) return r;
+
+    // Un périphérique synchrone répond à la première lecture ; sinon la lecture
+    // rend 0 et l'on attend que la réponse soit disponible
+    r = transport.receive(responseBuf, MCP2210_REPORT_TIMEOUT_INFINITE);
+    while (r == 0) {
+        r = transport.wait(MCP2210_REPORT_TIMEOUT_INFINITE);
+        if (r < 0) return r;
+        r = transport.receive(responseBuf, MCP2210_REPORT_TIMEOUT_INFINITE);
+    }
+    if (r < 0) return r;
+    return responseBuf[1];
+}
+
+// Table d'entrées d'un type de transport pour les poignées de mcp2210.cpp
+template <typename Transport>
+struct MCP2210TransportBinding {
+    static int exchange(void* transport, byte* cmdBuf, byte* responseBuf) {
+        return ExchangeReports(*static_cast<Transport*>(transport), cmdBuf, responseBuf);
+    }
+
+    static int fd(void* transport) {
+        return static_cast<Transport*>(transport)->fd();
+    }
+
+    static constexpr MCP2210TransportOps ops = {&exchange, &fd};
+};
+
+// Nouvelle poignée servie par le transport (NULL si toutes les places sont prises)
+template <typename Transport>
+hid_device* OpenMCP2210Transport(Transport& transport) {
+    return BindMCP2210Transport(&MCP2210TransportBinding<Transport>::ops, &transport);
+}
+
+// Transport rendu par InitMCP2210() à la place d'un périphérique USB
+template <typename Transport>
+void InstallMCP2210Transport(Transport& transport) {
+    SetMCP2210DefaultTransport(&MCP2210TransportBinding<Transport>::ops, &transport);
+}
+
+// Chemin de production : hidapi, sans indirection
+class HidapiTransport {
+public:
+    explicit HidapiTransport(hid_device* device) : device(device) {}
+
+    int submit(const byte* report) {
+        return hid_write(device, report, COMMAND_BUFFER_LENGTH) < 0 ? ERROR_UNABLE_TO_WRITE_TO_DEVICE : 0;
+    }
+
+    int receive(byte* report, int timeoutMs) {
+        // Sans délai, le mode bloquant/non bloquant choisi pour le périphérique s'applique
+        int r = timeoutMs < 0 ? hid_read(device, report, RESPONSE_BUFFER_LENGTH)
+                              : hid_read_timeout(device, report, RESPONSE_BUFFER_LENGTH, timeoutMs);
+        return r < 0 ? ERROR_UNABLE_TO_READ_FROM_DEVICE : r;
+    }
+
+    int wait(int) {
+#ifdef _WIN32
+        std::this_thread::sleep_for(std::chrono::milliseconds(1)); // hidapi n'expose pas de handle à attendre
+#endif
+        return 1;
+    }
+
+    int fd() const {
+        return -1;
+    }
+
+private:
+    hid_device* device;
+};
+
+#ifdef __linux__
+// Nœud /dev/hidrawN piloté directement : write, poll puis read, comme hid.c, avec
+// un descripteur que la boucle d'événements de l'appelant peut surveiller
+class HidrawTransport {
+public:
+    explicit HidrawTransport(const std::string& path);
+    explicit HidrawTransport(int fd); // Descripteur fourni par l'appelant, fermé par le transport
+    ~HidrawTransport();
+    HidrawTransport(const HidrawTransport&) = delete;
+    HidrawTransport& operator=(const HidrawTransport&) = delete;
+
+    int submit(const byte* report);
+    int receive(byte* report, int timeoutMs);
+    int wait(int timeoutMs);
+    int fd() const;
+
+private:
+    int deviceFd;
+};
+#endif
+
+// MCP2210 en mémoire : chaque rapport soumis est servi aussitôt par un gestionnaire
+// (simulateur, transport nul des mesures) et sa réponse mise en file
+class LoopbackTransport {
+public:
+    LoopbackTransport(MCP2210VirtualHandler handler = NULL, void* context = NULL);
+    ~LoopbackTransport();
+    LoopbackTransport(const LoopbackTransport&) = delete;
+    LoopbackTransport& operator=(const LoopbackTransport&) = delete;
+
+    void setResponder(MCP2210VirtualHandler handler, void* context);
+
+    int submit(const byte* report);
+    int receive(byte* report, int timeoutMs);
+    int wait(int timeoutMs);
+    int fd() const; // eventfd créé à la première demande (Linux), -1 ailleurs
+
+private:
+    MCP2210VirtualHandler handler;
+    void* context;
+    byte responses[MCP2210_LOOPBACK_DEPTH][RESPONSE_BUFFER_LENGTH];
+    unsigned int head;
+    unsigned int count;
+    mutable int eventFd;
+};
+
+// Une ligne par rapport : "> " soumis, "< " reçu (128 chiffres hexadécimaux),
+// "! " code d'erreur du rapport précédent
+void WriteRecordedReport(std::ostream& out, char direction, const byte* report);
+void WriteRecordedStatus(std::ostream& out, int status);
+
+// Enregistre le trafic d'un autre transport, pour le rejouer sans adaptateur
+template <typename Inner>
+class RecordingTransport {
+public:
+    RecordingTransport(Inner& inner, const std::string& path) : inner(inner), out(path) {
+        if (!out) {
+            throw std::runtime_error("Erreur : impossible de créer l'enregistrement " + path + ".");
+        }
+        out << MCP2210_RECORDING_HEADER << '\n';
+    }
+
+    int submit(const byte* report) {
+        int r = inner.submit(report);
+        WriteRecordedReport(out, '>', report);
+        if (r < 0) WriteRecordedStatus(out, r);
+        return r;
+    }
+
+    int receive(byte* report, int timeoutMs) {
+        int r = inner.receive(report, timeoutMs);
+        if (r > 0) WriteRecordedReport(out, '<', report);
+        else if (r < 0) WriteRecordedStatus(out, r);
+        return r;
+    }
+
+    int wait(int timeoutMs) {
+        return inner.wait(timeoutMs);
+    }
+
+    int fd() const {
+        return inner.fd();
+    }
+
+private:
+    Inner& inner;
+    std::ofstream out;
+};
+
+// Rejoue un enregistrement : chaque rapport soumis doit être identique à celui
+// enregistré (sinon ERROR_TRANSPORT_REPLAY_MISMATCH), les réponses et erreurs
+// enregistrées sont rendues dans l'ordre
+class ReplayTransport {
+public:
+    explicit ReplayTransport(const std::string& path);
+
+    int submit(const byte* report);
+    int receive(byte* report, int timeoutMs);
+    int wait(int timeoutMs);
+    int fd() const;
+
+    size_t position() const;  // Lignes consommées
+    bool finished() const;
+
+private:
+    struct Record {
+        char direction;  // '>', '<' ou '!'
+        int status;
+        byte report[COMMAND_BUFFER_LENGTH];
+    };
+
+    std::vector<Record> records;
+    size_t next;
+
+    int takeStatus(); // Erreur enregistrée à la suite du rapport courant, 0 sinon
+};
+
+#endif
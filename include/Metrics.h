@@ -0,0 +1,111 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "MCP2210Interface.h"
+
+#define METRICS_LATENCY_BUCKETS 11
+#define METRICS_OPCODES 256
+#define METRICS_LIBRARY_ERRORS 100 // Codes négatifs de mcp2210.h (jusqu'à ERROR_INVALID_DEVICE_HANDLE)
+
+// Histogramme de durées à bornes fixes ; chaque observation est une poignée
+// d'incréments atomiques relâchés, sans verrou
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void observe(double micros);
+    uint64_t count() const;
+    void write(std::ostream& out, const char* name, const std::string& labels) const;
+
+private:
+    std::atomic<uint64_t> buckets[METRICS_LATENCY_BUCKETS]; // Non cumulés, le dernier est +Inf
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sumNanos;
+};
+
+// Compteurs du chemin MCP2210, communs au processus. Les écritures n'imposent
+// aucun ordre (memory_order_relaxed) : un export peut voir des compteurs
+// légèrement décalés entre eux, jamais des valeurs déchirées.
+class Metrics {
+public:
+    static Metrics& global();
+
+    // Branche l'observateur de commandes USB de mcp2210.cpp (commandes chronométrées)
+    void observeCommands();
+    void stopObservingCommands();
+
+    void recordCommand(uint8_t opcode, int result, uint8_t engineStatus, double micros);
+    void recordSpiTransfer(size_t bytes, double micros);
+    void recordSpiOutcome(const SPITransferOutcomeDef& outcome);
+    void recordReconnect();
+    void recordCacheHit();
+    void recordCacheMiss();
+    void recordCacheStale();
+    void recordPotWrite(int pot);
+    void recordPotStore(int pot);
+
+    // Format texte Prometheus 0.0.4 (compatible OpenMetrics en lecture)
+    void writePrometheus(std::ostream& out) const;
+
+private:
+    Metrics();
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    LatencyHistogram commandLatency[METRICS_OPCODES];
+    std::atomic<uint64_t> libraryErrors[METRICS_LIBRARY_ERRORS];
+    std::atomic<uint64_t> deviceErrors[256];      // Octet d'état MCP2210 non nul
+    std::atomic<uint64_t> engineStatuses[256];    // Réponses aux rapports de transfert SPI
+    LatencyHistogram spiTransferLatency;
+    LatencyHistogram spiOutcomeLatency[SPI_TRANSFER_BUS_UNAVAILABLE + 1]; // Indexé par SPI_TRANSFER_*
+    std::atomic<uint64_t> spiCancellations;
+    std::atomic<uint64_t> spiBytes;
+    std::atomic<uint64_t> reconnects;
+    std::atomic<uint64_t> cacheHits;
+    std::atomic<uint64_t> cacheMisses;
+    std::atomic<uint64_t> cacheStale;
+    std::atomic<uint64_t> potWrites[NUM_POTS];
+    std::atomic<uint64_t> potStores[NUM_POTS];
+};
+
+// Export périodique : fichier texte réécrit atomiquement (collecteur textfile de
+// node_exporter) et/ou point d'accès HTTP local, en TCP sur 127.0.0.1 ou sur
+// une socket Unix ("unix:/chemin")
+class MetricsExporter {
+public:
+    MetricsExporter(const Metrics& metrics, const std::string& listen, const std::string& textfile,
+                    std::chrono::seconds period);
+    ~MetricsExporter();
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    std::string endpoint() const; // Adresse effective (port attribué si 0 demandé)
+    void writeTextfile() const;
+
+private:
+    const Metrics& metrics;
+    std::string textfilePath;
+    std::string unixPath;
+    std::string boundEndpoint;
+    std::chrono::seconds period;
+    int listenFd;
+    int wakeFds[2];
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    bool running;
+
+    void listenOn(const std::string& listen);
+    void run();
+    void serveClient(int fd) const;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef OPERATION_PLAN_H
+#define OPERATION_PLAN_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include "MCP2210Interface.h"
+#include "TransferCostModel.h"
+
+// État final souhaité pour un potentiomètre ; les étapes s'exécutent dans cet ordre
+struct PotPlan {
+    bool enableWrite;  // Registre de contrôle 0x1C03 : écriture RDAC autorisée
+    bool write;
+    uint16_t value;
+    bool verify;       // Relecture RDAC comparée à value
+    bool store;        // Stockage en mémoire 50-TP
+};
+
+// Un transfert SPI (une fenêtre CS) contenant une ou plusieurs trames de chaîne consécutives.
+// La réponse d'une trame de lecture sort pendant la trame suivante du même transfert.
+struct PlannedTransfer {
+    std::vector<uint8_t> frames;
+    std::vector<std::string> steps;   // Description de chaque trame
+    std::vector<size_t> readFrames;   // Index des trames de lecture
+    std::bitset<NUM_POTS> stores;     // Potentiomètres stockés par ce transfert
+};
+
+// Compile des modifications par potentiomètre en un minimum de trames de chaîne :
+// l'étape k de chaque potentiomètre partage la trame k, les autres positions reçoivent un NOP.
+class OperationPlan {
+public:
+    static OperationPlan compile(const std::vector<PotPlan>& pots);
+
+    const std::vector<PlannedTransfer>& transfers() const;
+    const std::vector<PotPlan>& pots() const;
+    size_t perPotTransactions() const; // Coût de l'approche une transaction par étape et par potentiomètre
+    CostEstimate cost(const TransferCostModel& model) const;
+    void print(std::ostream& out, const TransferCostModel& model) const;
+
+private:
+    std::vector<PotPlan> potPlans;
+    std::vector<PlannedTransfer> plannedTransfers;
+    size_t naiveTransactions;
+};
+
+#endif
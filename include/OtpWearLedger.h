@@ -0,0 +1,30 @@
+#ifndef OTP_WEAR_LEDGER_H
+#define OTP_WEAR_LEDGER_H
+
+#include <map>
+#include <string>
+#include <utility>
+
+#define OTP_SLOT_COUNT 50                            // Emplacements de la mémoire 50-TP
+#define OTP_WEAR_LEDGER_FILE "mcp2210_otp_wear.txt" // Dans le répertoire d'état de l'utilisateur
+
+// Nombre d'emplacements 50-TP consommés, par numéro de série d'adaptateur et position dans la chaîne
+class OtpWearLedger {
+public:
+    explicit OtpWearLedger(const std::string& path = defaultPath());
+
+    // Emplacement fixe par utilisateur, quel que soit le répertoire courant :
+    // $XDG_STATE_HOME/mcp2210 ou ~/.local/state/mcp2210, %LOCALAPPDATA%\mcp2210 sous Windows
+    static std::string defaultPath();
+
+    unsigned int slotsUsed(const std::string& serial, int position) const;
+    unsigned int slotsLeft(const std::string& serial, int position) const;
+    void recordStore(const std::string& serial, int position);
+    void save() const;
+
+private:
+    std::string path;
+    std::map<std::pair<std::string, int>, unsigned int> counts;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef POT_TRAITS_H
+#define POT_TRAITS_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Familles de potentiomètres numériques pouvant cohabiter dans une chaîne
+enum class PotFamily {
+    AD5270,   // 1024 positions, mémoire 50-TP
+    AD5271,   // 256 positions, mémoire 50-TP, valeur sur D9..D2
+    MCP42010  // 256 positions, volatile, pas de relecture
+};
+
+// Caractéristiques de chaque famille, résolues à la compilation.
+// Les fonctions de codage sont sans branchement : une spécialisation par famille.
+template <PotFamily Family>
+struct PotTraits;
+
+template <>
+struct PotTraits<PotFamily::AD5270> {
+    static constexpr const char* name = "ad5270";
+    static constexpr size_t frameBytes = 2;
+    static constexpr uint16_t maxValue = 0x03FF;
+    static constexpr bool hasOtp = true;
+    static constexpr bool hasReadback = true;
+
+    // Trame : 2 bits nuls, commande sur 4 bits, valeur sur 10 bits
+    static void encodeWrite(uint16_t value, uint8_t* frame) {
+        frame[0] = 0x04 | ((value >> 8) & 0x03);
+        frame[1] = value & 0xFF;
+    }
+    static uint16_t decodeValue(const uint8_t* frame) {
+        return static_cast<uint16_t>(((frame[0] & 0x03) << 8) | frame[1]);
+    }
+    static void encodeRead(uint8_t* frame) { frame[0] = 0x08; frame[1] = 0x00; }
+    static void encodeStore(uint8_t* frame) { frame[0] = 0x0C; frame[1] = 0x0C; }
+    static void encodeEnableWrite(uint8_t* frame) { frame[0] = 0x1C; frame[1] = 0x03; }
+    static void encodeNop(uint8_t* frame) { frame[0] = 0x00; frame[1] = 0x00; }
+};
+
+template <>
+struct PotTraits<PotFamily::AD5271> {
+    static constexpr const char* name = "ad5271";
+    static constexpr size_t frameBytes = 2;
+    static constexpr uint16_t maxValue = 0x00FF;
+    static constexpr bool hasOtp = true;
+    static constexpr bool hasReadback = true;
+
+    // Même jeu de commandes que l'AD5270, la valeur 8 bits occupe D9..D2
+    static void encodeWrite(uint16_t value, uint8_t* frame) {
+        uint16_t word = static_cast<uint16_t>((value & 0xFF) << 2);
+        frame[0] = 0x04 | (word >> 8);
+        frame[1] = word & 0xFF;
+    }
+    static uint16_t decodeValue(const uint8_t* frame) {
+        return static_cast<uint16_t>((((frame[0] & 0x03) << 8) | frame[1]) >> 2);
+    }
+    static void encodeRead(uint8_t* frame) { frame[0] = 0x08; frame[1] = 0x00; }
+    static void encodeStore(uint8_t* frame) { frame[0] = 0x0C; frame[1] = 0x0C; }
+    static void encodeEnableWrite(uint8_t* frame) { frame[0] = 0x1C; frame[1] = 0x03; }
+    static void encodeNop(uint8_t* frame) { frame[0] = 0x00; frame[1] = 0x00; }
+};
+
+template <>
+struct PotTraits<PotFamily::MCP42010> {
+    static constexpr const char* name = "mcp42010";
+    static constexpr size_t frameBytes = 2;
+    static constexpr uint16_t maxValue = 0x00FF;
+    static constexpr bool hasOtp = false;
+    static constexpr bool hasReadback = false;
+
+    // Octet de commande 0x11 (écriture, potentiomètre 0) puis valeur ; 0x00 = aucune commande
+    static void encodeWrite(uint16_t value, uint8_t* frame) {
+        frame[0] = 0x11;
+        frame[1] = value & 0xFF;
+    }
+    static uint16_t decodeValue(const uint8_t* frame) {
+        return frame[1];
+    }
+    static void encodeRead(uint8_t* frame) { frame[0] = 0x00; frame[1] = 0x00; }
+    static void encodeStore(uint8_t* frame) { frame[0] = 0x00; frame[1] = 0x00; }
+    static void encodeEnableWrite(uint8_t* frame) { frame[0] = 0x00; frame[1] = 0x00; }
+    static void encodeNop(uint8_t* frame) { frame[0] = 0x00; frame[1] = 0x00; }
+};
+
+// Famille de la chaîne principale (NUM_POTS potentiomètres)
+typedef PotTraits<PotFamily::AD5270> DefaultPotTraits;
+
+#endif
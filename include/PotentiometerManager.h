@@ -2,20 +2,130 @@
 #define POTENTIOMETER_MANAGER_H
 
 #include <vector>
+#include <chrono>
+#include <mutex>
 #include "MCP2210Interface.h"
+#include "PresetBank.h"
+#include "Crossfade.h"
+#include "OtpWearLedger.h"
+#include "GpioShadow.h"
+#include "ChainSet.h"
+#include "TransferCostModel.h"
+#include "OperationPlan.h"
+#include "StateSnapshot.h"
+#include <memory>
+
+// Compteurs du cache de lecture des valeurs RDAC
+struct CacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t staleRefreshes; // Relectures matérielles différentes du cache (réinitialisation détectée)
+};
+
+// Résultat d'une mise à jour déclenchée par la broche GP6
+struct TriggerResult {
+    bool fired;
+    unsigned int polls;
+    double latencyMicros;     // Estimation déclenchement -> fin du transfert SPI
+    double uncertaintyMicros; // Demi-intervalle entre les deux derniers sondages
+};
 
 class PotentiometerManager {
 public:
-    PotentiometerManager();
+    explicit PotentiometerManager(const std::string& pathCacheFile = "");
     ~PotentiometerManager();
 
     std::vector<uint16_t> readCurrentResistances();
     std::vector<uint16_t> readMemoryResistances();
     void programResistances(const std::vector<uint16_t>& values);
-    void storeResistancesToMemory();
+    std::bitset<NUM_POTS> storeResistancesToMemory();
+    std::vector<unsigned int> otpSlotsUsed();
+    std::bitset<NUM_POTS> programAndVerify(const std::vector<uint16_t>& values);
+    void applyPreset(const PresetBank& bank, size_t index);
+    void programFrames(const uint8_t* frames); // CHAIN_TRANSFER_LENGTH octets déjà encodés
+    std::bitset<NUM_POTS> executePlan(const OperationPlan& plan); // Stockages déjà en mémoire retirés, cycle 50-TP attendu
+
+    // Variantes sans exception (boucles de reprise) ; les méthodes ci-dessus lèvent leur erreur
+    Expected<std::vector<uint16_t>> tryReadCurrentResistances();
+    Expected<void> tryProgramResistances(const std::vector<uint16_t>& values);
+    Expected<std::bitset<NUM_POTS>> tryProgramAndVerify(const std::vector<uint16_t>& values);
+
+    StreamStats streamFrames(const uint8_t* frames, size_t count, std::chrono::microseconds period);
+    StreamStats crossfade(const std::vector<uint16_t>& target, std::chrono::milliseconds duration,
+                          TaperMode mode, unsigned int updateRate = 200);
+
+    // Mise à jour armée : envoyée dès que le compteur d'événements GP6 avance
+    void configureTriggerPin(unsigned int countMode = COUNT_RISING_EDGES);
+    TriggerResult programOnTrigger(const std::vector<uint16_t>& values, std::chrono::milliseconds timeout,
+                                   std::chrono::microseconds maxPollInterval = std::chrono::microseconds(0));
+
+    void enableArbitration(std::chrono::milliseconds timeout, bool externalMaster = false);
+    const AdapterLock* arbitration() const;
+
+    // Surveillance de l'adaptateur (appelables depuis le thread de HealthMonitor)
+    bool probe();
+    bool faultDetected() const;
+    void reconnect();
+
+    // Prévision de durée, calibrée sur les transferts effectués
+    CostEstimate estimate(ChainOperation operation);
+    CostEstimate estimate(const OperationPlan& plan);
+    TransferCostModel& costModel();
+    double measureRoundTrip(unsigned int samples);
+
+    // Paramètres SPI : une écriture recale le modèle de coût et force le ChainSet à les relire
+    SPITransferSettingsDef spiSettings();
+    void configureSpi(const SPITransferSettingsDef& settings);
+
+    // Limites des transferts SPI et issue (durée, sondages, annulation) du dernier transfert
+    void setTransferPolicy(const SPITransferPolicyDef& policy);
+    SPITransferPolicyDef transferPolicy() const;
+    SPITransferOutcomeDef lastTransferOutcome() const;
+
+    // Ouverture par chemin mémorisé ou par énumération, et délai jusqu'au premier transfert
+    OpenTiming openTiming() const;
+
+    std::string serialNumber();
+    uint8_t readEeprom(uint8_t address);
+    ChipStatusDef chipStatus();
+
+    // Publication de l'état des chaînes en mémoire partagée (lecteurs sans accès USB)
+    void enableStatePublishing();
+
+    GpioShadow& gpio();
+    ChainSet& chains();
+
+    // Cache optionnel des valeurs RDAC (ttl nul : pas d'expiration)
+    void enableCache(std::chrono::milliseconds ttl);
+    void disableCache();
+    void invalidateCache();
+    std::vector<uint16_t> refreshCurrentResistances();
+    Expected<std::vector<uint16_t>> tryRefreshCurrentResistances();
+    CacheStats cacheStats() const;
 
 private:
     MCP2210Interface mcpInterface;
+    OtpWearLedger wearLedger;
+    GpioShadow gpioShadow;
+    ChainSet chainSet;
+    TransferCostModel transferCostModel;
+    std::mutex costModelMutex;
+    std::unique_ptr<StatePublisher> statePublisher;
+
+    bool cacheEnabled;
+    bool cacheValid;
+    std::chrono::milliseconds cacheTtl;
+    std::chrono::steady_clock::time_point cacheTime;
+    std::vector<uint16_t> cachedValues;
+    CacheStats cacheCounters;
+
+    void updateCache(const std::vector<uint16_t>& values);
+    void recordProgrammedFrames(const uint8_t* frames);
+    void recordChainState(const std::vector<uint16_t>& values, bool written);
+    void recordWriteError();
+    void recordWriteError(const ErrorCode& error);
+    void recordVerifyErrors(const std::bitset<NUM_POTS>& mismatches);
+    void waitStoreCycle();
 };
 
 #endif
\ No newline at end of file
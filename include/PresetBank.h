@@ -0,0 +1,44 @@
+#ifndef PRESET_BANK_H
+#define PRESET_BANK_H
+
+#include <string>
+#include <vector>
+#include "MCP2210Interface.h"
+
+#define PRESET_NAME_LENGTH 32
+
+// Un préréglage : nom + trames SPI déjà encodées (écriture + trames vides)
+struct PresetRecord {
+    char name[PRESET_NAME_LENGTH];
+    uint8_t frames[CHAIN_TRANSFER_LENGTH];
+};
+
+class PresetBank {
+public:
+    PresetBank();
+    ~PresetBank();
+    PresetBank(const PresetBank&) = delete;
+    PresetBank& operator=(const PresetBank&) = delete;
+
+    size_t addPreset(const std::string& name, const std::vector<uint16_t>& values);
+    int findPreset(const std::string& name) const;
+    const uint8_t* frames(size_t index) const;
+    std::string name(size_t index) const;
+    size_t size() const;
+
+    void save(const std::string& path) const;
+    void load(const std::string& path);
+
+private:
+    std::vector<PresetRecord> ownedRecords; // Arène contiguë des préréglages
+    const PresetRecord* records;            // ownedRecords ou fichier projeté en mémoire
+    size_t recordCount;
+
+    void* mappedBase;
+    size_t mappedLength;
+
+    void makeOwned();
+    void unmap();
+};
+
+#endif
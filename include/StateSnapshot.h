@@ -0,0 +1,104 @@
+#ifndef STATE_SNAPSHOT_H
+#define STATE_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include "ChainSet.h"
+
+#define STATE_SNAPSHOT_MAGIC 0x5350434D // "MCPS"
+#define STATE_SNAPSHOT_VERSION 1
+#define STATE_SNAPSHOT_MAX_CHAINS 8     // Chaîne principale + chaînes du ChainSet
+
+#define POT_STATE_RDAC_KNOWN 0x01
+#define POT_STATE_MEMORY_KNOWN 0x02
+
+// État publié d'un potentiomètre
+struct PotState {
+    uint16_t rdac;
+    uint16_t memory;
+    uint32_t flags;          // POT_STATE_RDAC_KNOWN, POT_STATE_MEMORY_KNOWN
+    int64_t lastWriteNanos;  // Horloge système (ns depuis l'époque Unix), 0 si jamais écrit
+    uint32_t writeErrors;    // Transferts d'écriture échoués
+    uint32_t verifyErrors;   // Relectures différentes de la consigne
+};
+
+struct ChainState {
+    uint32_t length;
+    uint32_t reserved;
+    PotState pots[MAX_CHAIN_LENGTH];
+};
+
+// Copie cohérente de l'état de toutes les chaînes (chaîne 0 : chaîne principale)
+struct StateSnapshot {
+    uint32_t chainCount;
+    uint32_t reserved;
+    int64_t publishedNanos;
+    uint64_t transferErrors;
+    ChainState chains[STATE_SNAPSHOT_MAX_CHAINS];
+};
+
+// Segment de mémoire partagée : numéro de séquence (seqlock) puis instantané
+struct StateSegment {
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> sequence; // Impair pendant une mise à jour
+    uint32_t reserved;
+    StateSnapshot snapshot;
+};
+
+// Publie l'état des chaînes dans un segment partagé nommé d'après le numéro de série.
+// Un seul processus écrit (verrou exclusif pris à la construction, sinon exception) ;
+// les lecteurs ne font ni appel système ni accès USB.
+// Les chaînes au-delà de STATE_SNAPSHOT_MAX_CHAINS ne sont pas publiées.
+class StatePublisher {
+public:
+    explicit StatePublisher(const std::string& serial);
+    ~StatePublisher();
+    StatePublisher(const StatePublisher&) = delete;
+    StatePublisher& operator=(const StatePublisher&) = delete;
+
+    void publishValues(size_t chain, const std::vector<uint16_t>& values, bool written);
+    void publishMemory(size_t chain, const std::vector<uint16_t>& values);
+    void recordVerifyError(size_t chain, size_t position);
+    void recordWriteError(size_t chain);
+
+    static std::string segmentName(const std::string& serial);
+
+private:
+    std::string name;
+    StateSegment* segment;
+#ifdef _WIN32
+    void* mapping;
+    void* writerLock; // Mutex nommé, libéré par le système si l'écrivain meurt
+#else
+    int fd;           // Reste ouvert : porte le verrou flock exclusif de l'écrivain
+#endif
+    std::mutex writerMutex;
+
+    void begin();
+    void end();
+    ChainState& chainState(size_t chain, size_t length);
+};
+
+// Lecteur du segment publié par un autre processus
+class StateSnapshotReader {
+public:
+    explicit StateSnapshotReader(const std::string& serial);
+    ~StateSnapshotReader();
+    StateSnapshotReader(const StateSnapshotReader&) = delete;
+    StateSnapshotReader& operator=(const StateSnapshotReader&) = delete;
+
+    // Faux si l'écrivain n'a pas laissé de fenêtre stable après maxRetries tentatives
+    bool read(StateSnapshot& snapshot, unsigned int maxRetries = 1000) const;
+
+private:
+    const StateSegment* segment;
+#ifdef _WIN32
+    void* mapping;
+#endif
+};
+
+#endif
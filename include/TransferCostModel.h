@@ -0,0 +1,61 @@
+#ifndef TRANSFER_COST_MODEL_H
+#define TRANSFER_COST_MODEL_H
+
+#include <vector>
+#include <cstddef>
+#include "mcp2210.h"
+
+#define DEFAULT_USB_ROUND_TRIP_US 1000.0 // Un rapport HID toutes les 1 ms en full-speed
+#define DEFAULT_OTP_STORE_TIME_US 350000.0
+#define SPI_REPORT_PAYLOAD 60             // Octets SPI utiles par rapport USB
+
+enum class ChainOperation {
+    Read,
+    ReadMemory,
+    Program,
+    ProgramAndVerify,
+    Store,
+    Preset
+};
+
+struct CostEstimate {
+    unsigned int transfers;  // Appels SPISendReceive
+    unsigned int reports;    // Rapports USB (envois de données + sondages)
+    double spiMicros;        // Temps sur le bus SPI
+    double totalMicros;      // Durée prévue de l'opération
+};
+
+// Modèle de durée des transferts SPI à travers le MCP2210, calibré en ligne
+class TransferCostModel {
+public:
+    TransferCostModel();
+    explicit TransferCostModel(const SPITransferSettingsDef& settings, double roundTripMicros = DEFAULT_USB_ROUND_TRIP_US);
+
+    void setSettings(const SPITransferSettingsDef& settings);
+    void setRoundTrip(double micros);
+    void setStoreTime(double micros);
+    void setPollLimit(unsigned int maxPolls); // MaxPolls de la politique de transfert, 0 sans limite
+    double roundTrip() const;
+    double storeTime() const;
+
+    double spiMicros(size_t bytes) const;
+    unsigned int reportsFor(size_t bytes) const;
+    double transferMicros(size_t bytes) const;
+
+    CostEstimate estimateTransfers(const std::vector<size_t>& transferSizes) const;
+    CostEstimate estimate(ChainOperation operation) const;
+
+    // Aller-retour déduit de la durée et du nombre de rapports réellement échangés
+    void calibrate(const SPITransferOutcomeDef& outcome);
+    unsigned long calibrationSamples() const;
+
+private:
+    SPITransferSettingsDef settings;
+    double roundTripMicros;
+    double storeMicros;
+    unsigned int pollLimit;
+    unsigned int observedPolls; // Plus grand nombre de sondages « en cours » mesuré
+    unsigned long samples;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef VECTOR_STREAM_H
+#define VECTOR_STREAM_H
+
+#include <cstdio>
+#include <vector>
+#include <cstdint>
+
+#define VECTOR_STREAM_BUFFER_SIZE 65536
+
+enum class VectorFormat {
+    Text,   // Une ligne par vecteur, valeurs séparées par des virgules, espaces ou points-virgules
+    Binary  // NUM_POTS entiers 16 bits little-endian par vecteur, sans séparateur
+};
+
+// Lecture de vecteurs de valeurs RDAC depuis un flux, par blocs, dans un tampon réutilisé
+class VectorStreamParser {
+public:
+    VectorStreamParser(std::FILE* input, VectorFormat format, size_t vectorLength);
+
+    bool next(uint16_t* values); // Faux en fin de flux ; exception sur un vecteur mal formé
+    unsigned long vectorsRead() const;
+
+private:
+    std::FILE* input;
+    VectorFormat format;
+    size_t vectorLength;
+    std::vector<char> buffer;
+    size_t begin;
+    size_t end;
+    bool eof;
+    unsigned long lineNumber;
+    unsigned long vectors;
+
+    bool fill();
+    bool nextText(uint16_t* values);
+    bool nextBinary(uint16_t* values);
+    void parseLine(const char* first, const char* last, uint16_t* values);
+};
+
+#endif
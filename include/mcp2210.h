@@ -40,6 +40,11 @@ typedef uint8_t byte;
 #define GPIO_DIRECTION_OUTPUT 0
 #define GPIO_DIRECTION_INPUT 1
 
+/**
+ * Packed GPIO bit mask, bit n = GPn
+ */
+#define GPIO_PIN_MASK 0x1FF
+
 /** 
  * Response bit value for 
  * CMD_SET_NVRAM_PARAM 0x60, CMD_GET_NVRAM_PARAM 0x61
@@ -91,6 +96,8 @@ typedef uint8_t byte;
 #define ERROR_UNABLE_TO_OPEN_DEVICE -1
 #define ERROR_UNABLE_TO_WRITE_TO_DEVICE -2
 #define ERROR_UNABLE_TO_READ_FROM_DEVICE -3
+#define ERROR_SPI_TRANSFER_TIMEOUT -4
+#define ERROR_TRANSPORT_REPLAY_MISMATCH -5
 #define ERROR_INVALID_DEVICE_HANDLE -99
 
 #define COMMAND_BUFFER_LENGTH 64
@@ -100,6 +107,20 @@ typedef uint8_t byte;
 #define SPI_STATUS_STARTED_NO_DATA_TO_RECEIVE 0x20
 #define SPI_STATUS_SUCCESSFUL 0x30
 
+#define SPI_BUS_OWNER_NONE 0x00
+#define SPI_BUS_OWNER_USB_BRIDGE 0x01
+#define SPI_BUS_OWNER_EXTERNAL_MASTER 0x02
+#define SPI_BUS_RELEASE_EXT_REQ_PENDING 0x00
+#define SPI_BUS_OWNER_UNKNOWN 0xFF
+
+#define SPI_STATUS_BUS_NOT_AVAILABLE 0xF7
+#define SPI_STATUS_TRANSFER_IN_PROGRESS 0xF8
+
+#define SPI_TRANSFER_COMPLETED 0
+#define SPI_TRANSFER_FAILED 1
+#define SPI_TRANSFER_TIMED_OUT 2
+#define SPI_TRANSFER_BUS_UNAVAILABLE 3
+
 /**
  * General purpose pin definition
  */
@@ -387,6 +408,90 @@ struct SPIDataTransferStatusDef {
     int ErrorCode;
 };
 
+/**
+ * Limits applied by SPISendReceiveBounded
+ */
+struct SPITransferPolicyDef {
+    /**
+     * Maximum number of reports sent after the first one: engine status
+     * polls once the data has been accepted (0x20/0x30 replies) plus busy
+     * replies (0xF7/0xF8), 0 for no limit. MaxPolls and TimeoutMicros
+     * cannot both be 0.
+     */
+    unsigned int MaxPolls;
+
+    /**
+     * Deadline for the whole transfer in microseconds, 0 for no deadline
+     */
+    unsigned int TimeoutMicros;
+
+    /**
+     * Wait after the first busy reply (0xF7/0xF8), doubled after each
+     * further busy reply up to BackoffMaxMicros. 0 disables the backoff.
+     */
+    unsigned int BackoffMinMicros;
+    unsigned int BackoffMaxMicros;
+
+    /**
+     * Send CancelSPITransfer when a started transfer times out
+     */
+    bool CancelOnTimeout;
+};
+
+/**
+ * Result of SPISendReceiveBounded
+ */
+struct SPITransferOutcomeDef {
+    /**
+     * SPI_TRANSFER_COMPLETED, SPI_TRANSFER_FAILED, SPI_TRANSFER_TIMED_OUT
+     * or SPI_TRANSFER_BUS_UNAVAILABLE
+     */
+    int Outcome;
+
+    /**
+     * The last reply; the data is valid when the transfer completed.
+     * ErrorCode is ERROR_SPI_TRANSFER_TIMEOUT after a timeout.
+     */
+    SPIDataTransferStatusDef Status;
+
+    /**
+     * Engine status replies (0x20/0x30): the one that accepted the data,
+     * then one per empty status poll
+     */
+    unsigned int Polls;
+
+    /**
+     * Busy replies (0xF7: bus not available, 0xF8: transfer in progress)
+     */
+    unsigned int BusyReplies;
+
+    /**
+     * Last SPI engine status seen, 0 if the data was never accepted
+     */
+    unsigned int LastEngineStatus;
+
+    /**
+     * Last device status byte seen (0 or 0xF7/0xF8)
+     */
+    unsigned int LastDeviceStatus;
+
+    /**
+     * SPI bus owner read from the chip status when the bus was not available
+     * or the transfer was cancelled, SPI_BUS_OWNER_UNKNOWN otherwise
+     */
+    unsigned int SPIBusCurrentOwner;
+
+    /**
+     * true if CancelSPITransfer was sent
+     */
+    bool Cancelled;
+
+    /**
+     * Duration of the whole transfer, cancellation included
+     */
+    double ElapsedMicros;
+};
+
 /**
  * External interrupt pin (GP6) status definition
  */
@@ -462,6 +567,28 @@ hid_device* InitMCP2210(wchar_t* serialNumber);
  */
 hid_device* InitMCP2210(unsigned short vid, unsigned short pid, wchar_t* serialNumber);
 
+/**
+ * Open an MCP2210 by its device path (e.g. a remembered /dev/hidrawN) without
+ * enumerating the HID devices.
+ * 
+ * On Linux the VID/PID of the hidraw node is checked with a single
+ * HIDIOCGRAWINFO ioctl before the device is opened. When a serial number is
+ * given it must match the one of the opened device.
+ * 
+ * @param path
+ *      The device path, as reported by hid_enumerate() or hid_get_device_info()
+ * @param vid
+ *      The expected vendor ID
+ * @param pid
+ *      The expected product ID
+ * @param serialNumber
+ *      The expected serial number, NULL to accept any
+ * @return 
+ *      The handle to the MCP2210 device, NULL if the path is stale or
+ *      belongs to another device
+ */
+hid_device* InitMCP2210ByPath(const char *path, unsigned short vid, unsigned short pid, const wchar_t *serialNumber);
+
 /**
  * Release the device handle and close the device
  * 
@@ -470,6 +597,129 @@ hid_device* InitMCP2210(unsigned short vid, unsigned short pid, wchar_t* serialN
  */
 void ReleaseMCP2210(hid_device *handle);
 
+/**
+ * Handler serving the reports of a virtual MCP2210 (simulator, null transport)
+ * 
+ * @param context
+ *      The pointer given to SetMCP2210VirtualDevice
+ * @param cmdBuf
+ *      command buffer (64 bytes)
+ * @param responseBuf
+ *      the buffer (64 bytes) to fill with the response
+ * @return 
+ *      0:    Operation was successful
+ *      <0:  Other device errors (see error codes)
+ */
+typedef int (*MCP2210VirtualHandler)(void *context, byte *cmdBuf, byte *responseBuf);
+
+/**
+ * Install (or remove with a NULL handler) a virtual MCP2210. While installed,
+ * InitMCP2210() returns a handle whose commands are served by the handler
+ * instead of hidapi. The handler is wrapped in a LoopbackTransport installed
+ * as the default transport (see SetMCP2210DefaultTransport).
+ * 
+ * @param handler
+ *      The report handler, NULL to go back to USB devices
+ * @param context
+ *      Pointer passed back to the handler
+ */
+void SetMCP2210VirtualDevice(MCP2210VirtualHandler handler, void *context);
+
+/**
+ * Check whether a handle refers to the virtual MCP2210
+ * 
+ * @param handle
+ *      The handle to the MCP2210 device
+ * @return 
+ *      true if the handle is served by a bound transport rather than hidapi
+ */
+bool IsMCP2210VirtualDevice(hid_device *handle);
+
+#define MCP2210_MAX_TRANSPORTS 16 // Slot 0 is the default transport
+
+/**
+ * Type-erased entry points of a report transport. Tables are instantiated per
+ * transport type by MCP2210TransportBinding (MCP2210Transport.h), so the
+ * submit/receive/wait calls behind exchange are resolved at compile time.
+ */
+typedef struct {
+    /** Full command round trip, same result as SendUSBCmd */
+    int (*exchange)(void *transport, byte *cmdBuf, byte *responseBuf);
+    /** Pollable descriptor signalling a pending response, -1 if none */
+    int (*fd)(void *transport);
+} MCP2210TransportOps;
+
+/**
+ * Bind a transport to a new handle. Every command function accepts the handle;
+ * ReleaseMCP2210 leaves the transport to its owner.
+ * 
+ * @param ops
+ *      Entry points of the transport type
+ * @param transport
+ *      The transport object, owned by the caller
+ * @return 
+ *      The handle, or NULL when all MCP2210_MAX_TRANSPORTS slots are used
+ */
+hid_device* BindMCP2210Transport(const MCP2210TransportOps *ops, void *transport);
+
+/**
+ * Install (or remove with NULL ops) the default transport: while installed,
+ * InitMCP2210() and InitMCP2210ByPath() return its handle instead of opening
+ * a USB device.
+ * 
+ * @param ops
+ *      Entry points of the transport type, NULL to go back to USB devices
+ * @param transport
+ *      The transport object, owned by the caller
+ */
+void SetMCP2210DefaultTransport(const MCP2210TransportOps *ops, void *transport);
+
+/**
+ * Detach the transport of a handle returned by BindMCP2210Transport. Later
+ * commands on the handle fail with ERROR_INVALID_DEVICE_HANDLE.
+ * 
+ * @param handle
+ *      The transport handle
+ */
+void UnbindMCP2210Transport(hid_device *handle);
+
+/**
+ * Descriptor an event loop can poll for the responses of a handle
+ * 
+ * @param handle
+ *      The handle to the MCP2210 device
+ * @return 
+ *      The descriptor, or -1 when the transport has none (hidapi handles)
+ */
+int GetMCP2210TransportFd(hid_device *handle);
+
+/**
+ * Observer called after every USB command (metrics, tracing)
+ * 
+ * @param context
+ *      The pointer given to SetMCP2210CommandObserver
+ * @param cmdBuf
+ *      command buffer (64 bytes)
+ * @param responseBuf
+ *      response buffer (64 bytes)
+ * @param result
+ *      the value returned by SendUSBCmd
+ * @param micros
+ *      round trip time of the command, in microseconds
+ */
+typedef void (*MCP2210CommandObserver)(void *context, const byte *cmdBuf, const byte *responseBuf, int result, double micros);
+
+/**
+ * Install (or remove with a NULL observer) the USB command observer.
+ * Commands are only timed while an observer is installed.
+ * 
+ * @param observer
+ *      The observer, NULL to remove it
+ * @param context
+ *      Pointer passed back to the observer
+ */
+void SetMCP2210CommandObserver(MCP2210CommandObserver observer, void *context);
+
 /**
  * Send a USB command
  * 
@@ -746,6 +996,72 @@ SPIDataTransferStatusDef SPIDataTransfer(hid_device *handle, byte* data, int len
  */
 SPIDataTransferStatusDef SPISendReceive(hid_device *handle, byte* data, int cmdBufferLength, int dataLength = -1);
 
+/**
+ * Default limits used by SPISendReceive: 1 s deadline, 1000 engine polls,
+ * 100 us to 5 ms backoff on busy replies, cancellation on timeout
+ */
+SPITransferPolicyDef DefaultSPITransferPolicy();
+
+/**
+ * Account one reply of an SPI transfer against a policy. Shared by
+ * SPISendReceiveBounded and the batched hidraw transport, so both count
+ * polls and expire transfers the same way.
+ * 
+ * The data is sent until the engine accepts it (first 0x20/0x30 reply,
+ * outcome.Polls > 0); every later report is an empty status poll.
+ * 
+ * @param outcome
+ *      the transfer so far, updated with the reply (Polls, BusyReplies,
+ *      LastEngineStatus, LastDeviceStatus, Outcome)
+ * @param policy
+ *      the limits of the transfer
+ * @param status
+ *      the status byte of the reply, or a negative error code
+ * @param engineStatus
+ *      the SPI engine status of the reply (valid when status is 0)
+ * @param elapsedMicros
+ *      time since the first report of the transfer
+ * @return 
+ *      true when the transfer is over (outcome.Outcome is set), false when
+ *      another report must be sent
+ */
+bool SPITransferAccountReply(SPITransferOutcomeDef &outcome, const SPITransferPolicyDef &policy, int status,
+                             unsigned int engineStatus, double elapsedMicros);
+
+/**
+ * true when a transfer that ended with SPITransferAccountReply must be
+ * cancelled: it timed out while started in the engine and the policy
+ * asks for cancellation
+ */
+bool SPITransferNeedsCancel(const SPITransferOutcomeDef &outcome, const SPITransferPolicyDef &policy);
+
+/**
+ * Send data and wait till results are received from the SPI bus, within the
+ * limits of a policy.
+ * 
+ * The transfer goes through these states: submit (retried with backoff while
+ * the device replies 0xF7/0xF8), poll (empty reports while the engine replies
+ * 0x20/0x30), then completed (0x10), failed (USB error or other status), or
+ * timed out when the deadline or the maximum number of polls is reached. A
+ * started transfer that times out is cancelled with CancelSPITransfer.
+ * @see SPITransferAccountReply
+ * 
+ * @param handle
+ *      The handle to the MCP2210 device
+ * @param data
+ *      a pointer to the data array to be transfered
+ * @param cmdBufferLength
+ *      number of command bytes to be transfered
+ * @param dataLength
+ *      unused, kept for SPISendReceive: the status polls carry no data
+ * @param policy
+ *      the limits of the transfer
+ * @return 
+ *      @see SPITransferOutcomeDef
+ */
+SPITransferOutcomeDef SPISendReceiveBounded(hid_device *handle, byte* data, int cmdBufferLength, int dataLength,
+                                            const SPITransferPolicyDef &policy);
+
 /**
  * Get the current number of events from the interrupt pin
  * 
@@ -811,4 +1127,56 @@ GPPinDef GetGPIOPinValue(hid_device *handle);
  */
 int SetGPIOPinVal(hid_device *handle, GPPinDef def);
 
+/**
+ * Get GPIO current pin values as a packed bit mask
+ *
+ * @param handle
+ *      The handle to the MCP2210 device
+ * @param bits
+ *      bit n holds the value of GPn (GPIO_PIN_MASK)
+ * @return
+ *      0:    Operation was successful
+ *      <0:  Other device errors (see error codes)
+ */
+int GetGPIOPinValueBits(hid_device *handle, unsigned int *bits);
+
+/**
+ * Set GPIO current pin values from a packed bit mask
+ *
+ * @param handle
+ *      The handle to the MCP2210 device
+ * @param bits
+ *      bit n holds the value of GPn (GPIO_PIN_MASK)
+ * @return
+ *      0:    Operation was successful
+ *      <0:  Other device errors (see error codes)
+ */
+int SetGPIOPinValueBits(hid_device *handle, unsigned int bits);
+
+/**
+ * Get GPIO current pin directions as a packed bit mask
+ *
+ * @param handle
+ *      The handle to the MCP2210 device
+ * @param bits
+ *      bit n holds the direction of GPn (1: input, 0: output)
+ * @return
+ *      0:    Operation was successful
+ *      <0:  Other device errors (see error codes)
+ */
+int GetGPIOPinDirectionBits(hid_device *handle, unsigned int *bits);
+
+/**
+ * Set GPIO current pin directions from a packed bit mask
+ *
+ * @param handle
+ *      The handle to the MCP2210 device
+ * @param bits
+ *      bit n holds the direction of GPn (1: input, 0: output)
+ * @return
+ *      0:    Operation was successful
+ *      <0:  Other device errors (see error codes)
+ */
+int SetGPIOPinDirectionBits(hid_device *handle, unsigned int bits);
+
 #endif
\ No newline at end of file
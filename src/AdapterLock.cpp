@@ -0,0 +1,140 @@
+#include "AdapterLock.h"
+#include <stdexcept>
+#include <thread>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cstdlib>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Le numéro de série vient de l'adaptateur : rien qui puisse sortir du répertoire
+static std::string lockName(const std::string& serial) {
+    std::string name = "mcp2210-";
+    for (char c : serial) {
+        bool plain = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+        name += plain ? c : '_';
+    }
+    return name + ".lock";
+}
+
+#ifndef _WIN32
+// Répertoire privé : créé 0700, refusé s'il n'appartient pas à l'utilisateur ou s'il est ouvert aux autres
+static std::string privateLockDirectory() {
+    const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime && runtime[0] == '/') {
+        return runtime;
+    }
+
+    std::string dir = "/tmp/mcp2210-" + std::to_string(getuid());
+    if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Erreur : impossible de créer le répertoire de verrous " + dir + ".");
+    }
+    struct stat st;
+    if (lstat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != getuid() || (st.st_mode & 0077) != 0) {
+        throw std::runtime_error("Erreur : répertoire de verrous " + dir + " non sûr.");
+    }
+    return dir;
+}
+#endif
+
+std::string AdapterLock::lockPath(const std::string& serial) {
+#ifdef _WIN32
+    char tempDir[MAX_PATH] = {0};
+    GetTempPathA(MAX_PATH, tempDir); // Répertoire temporaire propre à l'utilisateur
+    return std::string(tempDir) + lockName(serial);
+#else
+    return privateLockDirectory() + "/" + lockName(serial);
+#endif
+}
+
+AdapterLock::AdapterLock(const std::string& serial, std::chrono::milliseconds timeout)
+    : timeout(timeout), held(false) {
+    std::string path = lockPath(serial);
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                       NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Erreur : impossible d'ouvrir le fichier de verrou de l'adaptateur.");
+    }
+#else
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Erreur : impossible d'ouvrir le fichier de verrou de l'adaptateur.");
+    }
+#endif
+}
+
+AdapterLock::~AdapterLock() {
+    if (held) {
+        release();
+    }
+#ifdef _WIN32
+    CloseHandle(file);
+#else
+    close(fd);
+#endif
+}
+
+bool AdapterLock::tryLock() {
+#ifdef _WIN32
+    OVERLAPPED overlapped = {0};
+    return LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &overlapped) != 0;
+#else
+    return flock(fd, LOCK_EX | LOCK_NB) == 0;
+#endif
+}
+
+void AdapterLock::acquire() {
+    if (!tryAcquire()) {
+        throw std::runtime_error("Erreur : adaptateur occupé par un autre processus.");
+    }
+}
+
+bool AdapterLock::tryAcquire() {
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + timeout;
+    std::chrono::microseconds backoff(20);
+
+    // Tentatives non bloquantes : le délai maximal reste maîtrisé
+    while (!tryLock()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(backoff);
+        backoff = std::min(backoff * 2, std::chrono::microseconds(1000));
+    }
+
+    acquiredAt = std::chrono::steady_clock::now();
+    held = true;
+    waits.add(std::chrono::duration<double, std::micro>(acquiredAt - start).count());
+    return true;
+}
+
+void AdapterLock::release() {
+    if (!held) return;
+
+#ifdef _WIN32
+    OVERLAPPED overlapped = {0};
+    UnlockFileEx(file, 0, 1, 0, &overlapped);
+#else
+    flock(fd, LOCK_UN);
+#endif
+    held = false;
+
+    holds.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - acquiredAt).count());
+}
+
+const LatencyRecorder& AdapterLock::waitTimes() const {
+    return waits;
+}
+
+const LatencyRecorder& AdapterLock::holdTimes() const {
+    return holds;
+}
@@ -0,0 +1,101 @@
+#include "Benchmark.h"
+#include <stdexcept>
+#include <chrono>
+
+static const uint16_t BENCH_CHAIN_CS[BENCH_MAX_CHAIN_LENGTHS] = {0x002, 0x004, 0x008, 0x010, 0x080, 0x100};
+
+Benchmark::Benchmark(PotentiometerManager& manager, unsigned int iterations) : manager(manager), iterations(iterations) {
+    if (iterations == 0) {
+        throw std::runtime_error("Erreur : nombre d'itérations nul.");
+    }
+}
+
+void Benchmark::measure(const std::string& workload, unsigned int bitRate, size_t chainLength,
+                        const std::function<void(unsigned int)>& operation) {
+    BenchResult result;
+    result.workload = workload;
+    result.bitRate = bitRate;
+    result.chainLength = chainLength;
+
+    operation(0); // Échauffement : paramètres et chemins de code déjà chargés
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < iterations; ++i) {
+        auto operationStart = std::chrono::steady_clock::now();
+        operation(i);
+        result.latency.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - operationStart).count());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.opsPerSecond = seconds > 0.0 ? iterations / seconds : 0.0;
+
+    benchResults.push_back(result);
+}
+
+void Benchmark::run(const std::vector<unsigned int>& bitRates, const std::vector<size_t>& chainLengths) {
+    if (chainLengths.size() > BENCH_MAX_CHAIN_LENGTHS) {
+        throw std::runtime_error("Erreur : trop de longueurs de chaîne à balayer.");
+    }
+
+    // Les paramètres d'origine sont rétablis avant chaque débit : le balayage des chaînes modifie les CS
+    SPITransferSettingsDef original = manager.spiSettings();
+    std::vector<size_t> chainIndexes;
+    std::vector<uint16_t> low(NUM_POTS, 0x100), high(NUM_POTS, 0x300);
+
+    for (unsigned int bitRate : bitRates) {
+        SPITransferSettingsDef settings = original;
+        settings.BitRate = bitRate;
+        manager.configureSpi(settings);
+
+        measure("usb-rtt", bitRate, 0, [&](unsigned int) { manager.chipStatus(); });
+        measure("chain-read", bitRate, NUM_POTS, [&](unsigned int) { manager.refreshCurrentResistances(); });
+        measure("chain-program", bitRate, NUM_POTS, [&](unsigned int i) { manager.programResistances(i & 1 ? high : low); });
+        measure("program-verify", bitRate, NUM_POTS, [&](unsigned int i) { manager.programAndVerify(i & 1 ? high : low); });
+        measure("gpio-toggle", bitRate, 0, [&](unsigned int) {
+            manager.gpio().togglePins(BENCH_GPIO_PIN);
+            manager.gpio().flush();
+        });
+        measure("eeprom-read", bitRate, 0, [&](unsigned int i) { manager.readEeprom(static_cast<uint8_t>(i)); });
+
+        for (size_t c = 0; c < chainLengths.size(); ++c) {
+            size_t length = chainLengths[c];
+            if (chainIndexes.size() <= c) {
+                chainIndexes.push_back(manager.chains().addChain(BENCH_CHAIN_CS[c], length));
+            }
+            std::vector<uint16_t> chainLow(length, 0x100), chainHigh(length, 0x300);
+            measure("chain-program", bitRate, length, [&](unsigned int i) {
+                manager.chains().program(chainIndexes[c], i & 1 ? chainHigh : chainLow);
+            });
+        }
+
+        manager.configureSpi(original);
+    }
+}
+
+const std::vector<BenchResult>& Benchmark::results() const {
+    return benchResults;
+}
+
+void Benchmark::printSummary(std::ostream& out) const {
+    for (const BenchResult& result : benchResults) {
+        out << result.workload << " @ " << result.bitRate / 1000.0 << " kHz";
+        if (result.chainLength > 0) {
+            out << ", " << result.chainLength << " pots";
+        }
+        out << " : p50 " << result.latency.percentile(50) << " us, p90 " << result.latency.percentile(90)
+            << " us, p99 " << result.latency.percentile(99) << " us, " << result.opsPerSecond << " op/s\n";
+    }
+}
+
+void Benchmark::writeJson(std::ostream& out, const std::string& target) const {
+    out << "{\"target\":\"" << target << "\",\"iterations\":" << iterations << ",\"results\":[";
+    for (size_t i = 0; i < benchResults.size(); ++i) {
+        const BenchResult& result = benchResults[i];
+        out << (i ? "," : "") << "\n  {\"workload\":\"" << result.workload << "\",\"bitRate\":" << result.bitRate
+            << ",\"chainLength\":" << result.chainLength << ",\"samples\":" << result.latency.count()
+            << ",\"meanUs\":" << result.latency.mean() << ",\"minUs\":" << result.latency.min()
+            << ",\"p50Us\":" << result.latency.percentile(50) << ",\"p90Us\":" << result.latency.percentile(90)
+            << ",\"p99Us\":" << result.latency.percentile(99) << ",\"maxUs\":" << result.latency.max()
+            << ",\"opsPerSecond\":" << result.opsPerSecond << "}";
+    }
+    out << "\n]}\n";
+}
@@ -0,0 +1,134 @@
+#include "ChainLayout.h"
+#include <stdexcept>
+
+template <PotFamily Family>
+static constexpr PotFamilyInfo familyInfo() {
+    typedef PotTraits<Family> Traits;
+    return {Traits::name, Traits::frameBytes, Traits::maxValue, Traits::hasOtp, Traits::hasReadback};
+}
+
+// Table indexée par PotFamily, dans l'ordre de l'énumération
+static const PotFamilyInfo POT_FAMILIES[] = {
+    familyInfo<PotFamily::AD5270>(),
+    familyInfo<PotFamily::AD5271>(),
+    familyInfo<PotFamily::MCP42010>(),
+};
+
+const PotFamilyInfo& potFamilyInfo(PotFamily family) {
+    return POT_FAMILIES[static_cast<size_t>(family)];
+}
+
+PotFamily parsePotFamily(const std::string& name) {
+    for (size_t i = 0; i < sizeof(POT_FAMILIES) / sizeof(POT_FAMILIES[0]); ++i) {
+        if (name == POT_FAMILIES[i].name) {
+            return static_cast<PotFamily>(i);
+        }
+    }
+    throw std::runtime_error("Erreur : famille de potentiomètre inconnue \"" + name + "\".");
+}
+
+// Boucles d'un segment, instanciées par famille : les appels de PotTraits sont en ligne
+template <typename Traits>
+struct SegmentCodec {
+    static void encodeWrite(const uint16_t* values, uint8_t* frames, size_t count) {
+        for (size_t i = 0; i < count; ++i) Traits::encodeWrite(values[i], frames + i * Traits::frameBytes);
+    }
+    static void decodeValues(const uint8_t* frames, uint16_t* values, size_t count) {
+        for (size_t i = 0; i < count; ++i) values[i] = Traits::decodeValue(frames + i * Traits::frameBytes);
+    }
+    static void encodeRead(uint8_t* frames, size_t count) {
+        for (size_t i = 0; i < count; ++i) Traits::encodeRead(frames + i * Traits::frameBytes);
+    }
+    static void encodeStore(uint8_t* frames, size_t count) {
+        for (size_t i = 0; i < count; ++i) Traits::encodeStore(frames + i * Traits::frameBytes);
+    }
+};
+
+// Une sélection de famille par segment : l'opération reçoit les boucles de ses traits
+template <typename Operation>
+static void forFamily(PotFamily family, Operation&& operation) {
+    switch (family) {
+    case PotFamily::AD5270:
+        operation(SegmentCodec<PotTraits<PotFamily::AD5270>>());
+        break;
+    case PotFamily::AD5271:
+        operation(SegmentCodec<PotTraits<PotFamily::AD5271>>());
+        break;
+    case PotFamily::MCP42010:
+        operation(SegmentCodec<PotTraits<PotFamily::MCP42010>>());
+        break;
+    }
+}
+
+ChainLayout::ChainLayout() : totalLength(0) {}
+
+ChainLayout::ChainLayout(const std::vector<PotFamily>& parts) : parts(parts), totalLength(0) {
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (segments.empty() || segments.back().family != parts[i]) {
+            segments.push_back({parts[i], i, 0, totalLength});
+        }
+        ++segments.back().count;
+        totalLength += potFamilyInfo(parts[i]).frameBytes;
+    }
+}
+
+ChainLayout ChainLayout::uniform(PotFamily family, size_t length) {
+    return ChainLayout(std::vector<PotFamily>(length, family));
+}
+
+size_t ChainLayout::length() const {
+    return parts.size();
+}
+
+size_t ChainLayout::frameLength() const {
+    return totalLength;
+}
+
+PotFamily ChainLayout::family(size_t position) const {
+    return parts.at(position);
+}
+
+const PotFamilyInfo& ChainLayout::info(size_t position) const {
+    return potFamilyInfo(parts.at(position));
+}
+
+void ChainLayout::checkValues(const std::vector<uint16_t>& values) const {
+    if (values.size() != parts.size()) {
+        throw std::runtime_error("Erreur : le nombre de valeurs ne correspond pas à la longueur de la chaîne.");
+    }
+    for (size_t i = 0; i < values.size(); ++i) {
+        const PotFamilyInfo& family = potFamilyInfo(parts[i]);
+        if (values[i] > family.maxValue) {
+            throw std::runtime_error("Erreur : valeur hors limites pour le potentiomètre #" + std::to_string(i + 1)
+                                     + " (" + family.name + ", max " + std::to_string(family.maxValue) + ").");
+        }
+    }
+}
+
+void ChainLayout::encodeWrite(const uint16_t* values, uint8_t* frames) const {
+    for (const Segment& segment : segments) {
+        forFamily(segment.family, [&](auto codec) {
+            codec.encodeWrite(values + segment.first, frames + segment.offset, segment.count);
+        });
+    }
+}
+
+void ChainLayout::decodeValues(const uint8_t* frames, uint16_t* values) const {
+    for (const Segment& segment : segments) {
+        forFamily(segment.family, [&](auto codec) {
+            codec.decodeValues(frames + segment.offset, values + segment.first, segment.count);
+        });
+    }
+}
+
+void ChainLayout::encodeRead(uint8_t* frames) const {
+    for (const Segment& segment : segments) {
+        forFamily(segment.family, [&](auto codec) { codec.encodeRead(frames + segment.offset, segment.count); });
+    }
+}
+
+void ChainLayout::encodeStore(uint8_t* frames) const {
+    for (const Segment& segment : segments) {
+        forFamily(segment.family, [&](auto codec) { codec.encodeStore(frames + segment.offset, segment.count); });
+    }
+}
@@ -0,0 +1,205 @@
+#include "ChainSet.h"
+#include "StateSnapshot.h"
+#include <stdexcept>
+
+ChainSet::ChainSet(MCP2210Interface& mcpInterface)
+    : mcpInterface(mcpInterface), settings(), mainSettings(), settingsLoaded(false), settingsStale(false), transferring(false),
+      settingsGeneration(0), allChipSelects(0), counters{0, 0, 0, 0.0}, statePublisher(nullptr) {
+    // Tout transfert qui ne vient pas du ChainSet est destiné à la chaîne principale
+    mcpInterface.setMainChainSelector([this]() {
+        if (!transferring) selectMain();
+    });
+}
+
+ChainSet::~ChainSet() {
+    mcpInterface.setMainChainSelector(nullptr);
+}
+
+size_t ChainSet::addChain(uint16_t csMask, size_t length) {
+    if (length > MAX_CHAIN_LENGTH) {
+        throw std::runtime_error("Erreur : longueur de chaîne invalide.");
+    }
+    return addChain(csMask, ChainLayout::uniform(PotFamily::AD5270, length));
+}
+
+size_t ChainSet::addChain(uint16_t csMask, const ChainLayout& layout) {
+    csMask &= GPIO_PIN_MASK;
+    if (csMask == 0 || (csMask & allChipSelects) != 0) {
+        throw std::runtime_error("Erreur : masque CS vide ou déjà utilisé par une autre chaîne.");
+    }
+    if (layout.length() == 0 || layout.frameLength() > MAX_CHAIN_FRAME_LENGTH) {
+        throw std::runtime_error("Erreur : longueur de chaîne invalide.");
+    }
+    size_t length = layout.length();
+
+    allChipSelects |= csMask;
+    if (settingsLoaded) {
+        mcpInterface.designateChipSelects(csMask);
+    }
+
+    chains.push_back({csMask, layout, std::vector<uint16_t>(length, 0), std::vector<uint16_t>(length, 0), false});
+    return chains.size() - 1;
+}
+
+size_t ChainSet::size() const {
+    return chains.size();
+}
+
+void ChainSet::clear() {
+    if (chains.empty()) {
+        return;
+    }
+    selectMain();
+    chains.clear();
+    allChipSelects = 0;
+    invalidateSettings();
+}
+
+void ChainSet::stage(size_t chain, const std::vector<uint16_t>& values) {
+    if (chain >= chains.size()) {
+        throw std::runtime_error("Erreur : chaîne inexistante.");
+    }
+    chains[chain].layout.checkValues(values);
+    chains[chain].pending = values;
+    chains[chain].dirty = true;
+}
+
+void ChainSet::commit() {
+    // Un seul verrou pour les changements de CS et les transferts : aucun autre processus ne
+    // transfère entre les deux avec les CS d'une chaîne secondaire
+    MCP2210Interface::Transaction transaction(mcpInterface);
+
+    // La chaîne déjà sélectionnée passe en premier : son transfert ne demande aucun changement de CS
+    size_t first = chains.size();
+    if (settingsLoaded) {
+        for (size_t i = 0; i < chains.size(); ++i) {
+            if (chains[i].dirty && (settings.ActiveChipSelectValue & chains[i].csMask) == 0) {
+                first = i;
+                break;
+            }
+        }
+    }
+    if (first < chains.size()) {
+        send(chains[first]);
+    }
+
+    for (Chain& chain : chains) {
+        if (chain.dirty) {
+            send(chain);
+        }
+    }
+}
+
+void ChainSet::program(size_t chain, const std::vector<uint16_t>& values) {
+    stage(chain, values);
+    commit();
+}
+
+const std::vector<uint16_t>& ChainSet::shadow(size_t chain) const {
+    if (chain >= chains.size()) {
+        throw std::runtime_error("Erreur : chaîne inexistante.");
+    }
+    return chains[chain].shadow;
+}
+
+void ChainSet::invalidateSettings() {
+    settingsLoaded = false;
+    settingsStale = false;
+}
+
+void ChainSet::setStatePublisher(StatePublisher* publisher) {
+    statePublisher = publisher;
+}
+
+ChainSetStats ChainSet::stats() const {
+    ChainSetStats result = counters;
+    if (result.updates > 0) {
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - firstUpdate).count();
+        result.updatesPerSecond = elapsed > 0.0 ? result.updates / elapsed : 0.0;
+    }
+    return result;
+}
+
+// Seuls les champs CS et la taille du transfert changent d'une chaîne à l'autre
+void ChainSet::select(const Chain& chain) {
+    if (!settingsLoaded || settingsGeneration != mcpInterface.connectionGeneration()) {
+        mcpInterface.designateChipSelects(allChipSelects);
+        settings = mcpInterface.readSpiSettings();
+        if (!settingsLoaded) {
+            mainSettings = settings; // Après une reconnexion, ce sont ceux de la dernière chaîne écrite
+        }
+        settingsLoaded = true;
+        settingsStale = false;
+        settingsGeneration = mcpInterface.connectionGeneration();
+    }
+
+    SPITransferSettingsDef next = settings;
+    next.IdleChipSelectValue = settings.IdleChipSelectValue | allChipSelects; // CS des chaînes au repos (niveau haut)
+    next.ActiveChipSelectValue = next.IdleChipSelectValue & ~static_cast<unsigned int>(chain.csMask);
+    next.BytesPerSPITransfer = static_cast<unsigned int>(chain.layout.frameLength());
+    if (!apply(next)) {
+        ++counters.settingsSkipped;
+    }
+}
+
+// Écrit les paramètres s'ils diffèrent de ceux en place ; false si l'écriture est évitée
+bool ChainSet::apply(const SPITransferSettingsDef& next) {
+    if (!settingsStale && settings.IdleChipSelectValue == next.IdleChipSelectValue
+        && settings.ActiveChipSelectValue == next.ActiveChipSelectValue
+        && settings.BytesPerSPITransfer == next.BytesPerSPITransfer) {
+        return false;
+    }
+
+    settingsStale = true;
+    mcpInterface.writeSpiSettings(next);
+    settings = next;
+    settingsStale = false;
+    ++counters.settingsWrites;
+    return true;
+}
+
+void ChainSet::send(Chain& chain) {
+    select(chain);
+
+    uint8_t frames[MAX_CHAIN_FRAME_LENGTH];
+    chain.layout.encodeWrite(chain.pending.data(), frames);
+    transferring = true;
+    try {
+        mcpInterface.transferFrames(frames, chain.layout.frameLength());
+        transferring = false;
+    } catch (...) {
+        transferring = false;
+        if (statePublisher) {
+            statePublisher->recordWriteError(&chain - chains.data() + 1);
+        }
+        throw;
+    }
+
+    if (counters.updates == 0) {
+        firstUpdate = std::chrono::steady_clock::now();
+    }
+    ++counters.updates;
+    chain.shadow = chain.pending;
+    chain.dirty = false;
+    if (statePublisher) {
+        statePublisher->publishValues(&chain - chains.data() + 1, chain.shadow, true);
+    }
+}
+
+// La chaîne principale retrouve ses CS et sa taille de transfert
+void ChainSet::selectMain() {
+    MCP2210Interface::Transaction transaction(mcpInterface);
+    if (!settingsLoaded) {
+        return; // Aucune chaîne secondaire servie depuis la lecture des paramètres
+    }
+    // Une reconnexion a réécrit les derniers paramètres envoyés, sans garantie qu'ils aient abouti
+    if (settingsGeneration != mcpInterface.connectionGeneration()) {
+        settingsStale = true;
+        settingsGeneration = mcpInterface.connectionGeneration();
+    }
+    SPITransferSettingsDef next = settings;
+    next.IdleChipSelectValue = mainSettings.IdleChipSelectValue;
+    next.ActiveChipSelectValue = mainSettings.ActiveChipSelectValue;
+    next.BytesPerSPITransfer = mainSettings.BytesPerSPITransfer;
+    apply(next);
+}
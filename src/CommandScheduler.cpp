@@ -0,0 +1,136 @@
+#include "CommandScheduler.h"
+#include <stdexcept>
+
+CommandScheduler::CommandScheduler() : running(true), busy(false) {
+    for (LaneStats& stats : laneStats) {
+        stats.completed = 0;
+        stats.deadlineMisses = 0;
+        stats.steps = 0;
+    }
+    worker = std::thread(&CommandScheduler::run, this);
+}
+
+CommandScheduler::~CommandScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    workAvailable.notify_all();
+    worker.join();
+}
+
+std::future<void> CommandScheduler::submit(Lane lane, std::chrono::microseconds deadline, Step step) {
+    std::unique_ptr<Job> job(new Job);
+    job->lane = lane;
+    job->submitted = std::chrono::steady_clock::now();
+    job->deadline = job->submitted + deadline;
+    job->step = std::move(step);
+    std::future<void> result = job->done.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        lanes[static_cast<size_t>(lane)].push_back(std::move(job));
+    }
+    workAvailable.notify_one();
+    return result;
+}
+
+std::future<void> CommandScheduler::submitOnce(Lane lane, std::chrono::microseconds deadline, std::function<void()> action) {
+    return submit(lane, deadline, [action]() {
+        action();
+        return true;
+    });
+}
+
+// Attend que toutes les files soient vides
+void CommandScheduler::drain() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] {
+        if (busy) return false;
+        for (const auto& lane : lanes) {
+            if (!lane.empty()) return false;
+        }
+        return true;
+    });
+}
+
+LaneStats CommandScheduler::stats(Lane lane) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return laneStats[static_cast<size_t>(lane)];
+}
+
+// Priorité stricte entre les files, échéance la plus proche au sein d'une file
+bool CommandScheduler::pickJob(size_t& lane, size_t& index) const {
+    for (lane = 0; lane < LANE_COUNT; ++lane) {
+        if (lanes[lane].empty()) continue;
+        index = 0;
+        for (size_t i = 1; i < lanes[lane].size(); ++i) {
+            if (lanes[lane][i]->deadline < lanes[lane][index]->deadline) {
+                index = i;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+void CommandScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        size_t lane = 0;
+        size_t index = 0;
+        workAvailable.wait(lock, [&] { return !running || pickJob(lane, index); });
+        if (!running) break;
+
+        // L'étape s'exécute hors verrou ; le travail reste dans sa file pendant ce temps
+        Job* job = lanes[lane][index].get();
+        busy = true;
+        lock.unlock();
+
+        bool finished = true;
+        std::exception_ptr error;
+        try {
+            finished = job->step();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        lock.lock();
+        busy = false;
+        LaneStats& stats = laneStats[lane];
+        ++stats.steps;
+
+        if (finished || error) {
+            ++stats.completed;
+            if (now > job->deadline) {
+                ++stats.deadlineMisses;
+            }
+            stats.latency.add(std::chrono::duration<double, std::micro>(now - job->submitted).count());
+
+            // L'indice peut avoir changé si des travaux ont été ajoutés pendant l'étape
+            std::vector<std::unique_ptr<Job>>& queue = lanes[lane];
+            for (size_t i = 0; i < queue.size(); ++i) {
+                if (queue[i].get() == job) {
+                    std::unique_ptr<Job> completed = std::move(queue[i]);
+                    queue.erase(queue.begin() + i);
+                    if (error) {
+                        completed->done.set_exception(error);
+                    } else {
+                        completed->done.set_value();
+                    }
+                    break;
+                }
+            }
+        }
+        idle.notify_all();
+    }
+
+    // Travaux restants à l'arrêt : signalés comme abandonnés
+    for (auto& queue : lanes) {
+        for (auto& job : queue) {
+            job->done.set_exception(std::make_exception_ptr(std::runtime_error("Ordonnanceur arrêté.")));
+        }
+        queue.clear();
+    }
+}
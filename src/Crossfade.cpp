@@ -0,0 +1,63 @@
+#include "Crossfade.h"
+#include <stdexcept>
+#include <cmath>
+
+Crossfade::Crossfade(const std::vector<uint16_t>& from, const std::vector<uint16_t>& to, size_t steps, TaperMode mode)
+    : stepCount(steps), frameArena(steps * CHAIN_TRANSFER_LENGTH, 0x00) {
+    if (from.size() != NUM_POTS || to.size() != NUM_POTS) {
+        throw std::runtime_error("Erreur : le nombre de valeurs ne correspond pas au nombre de potentiomètres.");
+    }
+    if (steps == 0) {
+        throw std::runtime_error("Erreur : un fondu nécessite au moins une étape.");
+    }
+
+    // Tableaux par potentiomètre (structure de tableaux) : les boucles internes
+    // sont sans branchement et vectorisées par le compilateur.
+    float level[NUM_POTS];
+    float increment[NUM_POTS];
+    uint16_t values[NUM_POTS];
+    float intervals = steps > 1 ? static_cast<float>(steps - 1) : 1.0f;
+
+    if (mode == TaperMode::Linear) {
+        for (int i = 0; i < NUM_POTS; ++i) {
+            level[i] = from[i];
+            increment[i] = (static_cast<float>(to[i]) - from[i]) / intervals;
+        }
+    } else {
+        // Progression géométrique sur (valeur + 1) pour accepter la valeur 0
+        for (int i = 0; i < NUM_POTS; ++i) {
+            level[i] = from[i] + 1.0f;
+            increment[i] = std::pow((to[i] + 1.0f) / (from[i] + 1.0f), 1.0f / intervals);
+        }
+    }
+
+    for (size_t s = 0; s < steps; ++s) {
+        if (mode == TaperMode::Linear) {
+            for (int i = 0; i < NUM_POTS; ++i) {
+                values[i] = static_cast<uint16_t>(level[i] + 0.5f);
+                level[i] += increment[i];
+            }
+        } else {
+            for (int i = 0; i < NUM_POTS; ++i) {
+                values[i] = static_cast<uint16_t>(level[i] - 0.5f);
+                level[i] *= increment[i];
+            }
+        }
+        MCP2210Interface::encodeWriteFrames(values, &frameArena[s * CHAIN_TRANSFER_LENGTH]);
+    }
+
+    // La dernière étape correspond exactement à la cible, sans erreur d'arrondi cumulée
+    MCP2210Interface::encodeWriteFrames(to.data(), &frameArena[(steps - 1) * CHAIN_TRANSFER_LENGTH]);
+}
+
+size_t Crossfade::steps() const {
+    return stepCount;
+}
+
+const uint8_t* Crossfade::frames(size_t step) const {
+    return &frameArena[step * CHAIN_TRANSFER_LENGTH];
+}
+
+const uint8_t* Crossfade::data() const {
+    return frameArena.data();
+}
@@ -0,0 +1,54 @@
+#include "DevicePathCache.h"
+#include <stdexcept>
+#include <fstream>
+#include <cstdio>
+
+// Format texte, une ligne par adaptateur : <numéro de série> <chemin>, le plus récent en dernier
+DevicePathCache::DevicePathCache(const std::string& path) : path(path) {
+    std::ifstream file(path);
+    std::string serial;
+    std::string devicePath;
+    while (file >> serial && std::getline(file >> std::ws, devicePath)) {
+        entries.emplace_back(serial, devicePath);
+    }
+}
+
+std::string DevicePathCache::lookup(const std::string& serial) const {
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        if (it->first == serial) return it->second;
+    }
+    return std::string();
+}
+
+std::string DevicePathCache::lastSerial() const {
+    return entries.empty() ? std::string() : entries.back().first;
+}
+
+void DevicePathCache::remember(const std::string& serial, const std::string& devicePath) {
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->first == serial) {
+            entries.erase(it);
+            break;
+        }
+    }
+    entries.emplace_back(serial, devicePath);
+}
+
+void DevicePathCache::save() const {
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Erreur : impossible d'écrire le cache des chemins de périphérique.");
+        }
+        for (const auto& entry : entries) {
+            file << entry.first << " " << entry.second << "\n";
+        }
+    }
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Erreur : impossible d'écrire le cache des chemins de périphérique.");
+    }
+}
@@ -0,0 +1,26 @@
+#include "Expected.h"
+#include <cstdio>
+#include <stdexcept>
+
+std::string ErrorCode::describe() const {
+    std::string text = message;
+
+    // Détails matériels entre crochets : code USB, octet d'état, état du moteur SPI
+    char details[64];
+    if (libraryCode < 0) {
+        std::snprintf(details, sizeof(details), " [code %d]", libraryCode);
+        text += details;
+    } else if (deviceStatus != 0) {
+        std::snprintf(details, sizeof(details), " [état MCP2210 0x%02X]", deviceStatus);
+        text += details;
+    }
+    if (engineStatus != 0) {
+        std::snprintf(details, sizeof(details), " [moteur SPI 0x%02X]", engineStatus);
+        text += details;
+    }
+    return text;
+}
+
+void throwError(const ErrorCode& error) {
+    throw std::runtime_error(error.describe());
+}
@@ -0,0 +1,71 @@
+#include "FrameRing.h"
+#include <stdexcept>
+
+FrameRing::FrameRing(size_t depth, size_t frameLength)
+    : slots(depth * frameLength), depth(depth), frameLength(frameLength), head(0), count(0), closed(false),
+      fullWaits(0), emptyWaits(0) {
+    if (depth == 0) {
+        throw std::runtime_error("Erreur : file de trames de profondeur nulle.");
+    }
+}
+
+uint8_t* FrameRing::acquireSlot() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (count == depth && !closed) {
+        ++fullWaits;
+        notFull.wait(lock, [this]() { return count < depth || closed; });
+    }
+    if (closed) {
+        return nullptr;
+    }
+    // Seul le producteur écrit cet emplacement : il reste hors de la vue du consommateur jusqu'à publishSlot()
+    return &slots[((head + count) % depth) * frameLength];
+}
+
+void FrameRing::publishSlot() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++count;
+    }
+    notEmpty.notify_one();
+}
+
+const uint8_t* FrameRing::front() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (count == 0 && !closed) {
+        ++emptyWaits;
+        notEmpty.wait(lock, [this]() { return count > 0 || closed; });
+    }
+    if (count == 0) {
+        return nullptr;
+    }
+    return &slots[head * frameLength];
+}
+
+void FrameRing::releaseFront() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        head = (head + 1) % depth;
+        --count;
+    }
+    notFull.notify_one();
+}
+
+void FrameRing::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    notFull.notify_all();
+    notEmpty.notify_all();
+}
+
+unsigned long FrameRing::producerStalls() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fullWaits;
+}
+
+unsigned long FrameRing::consumerStalls() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return emptyWaits;
+}
@@ -0,0 +1,88 @@
+#include "GpioShadow.h"
+
+GpioShadow::GpioShadow(MCP2210Interface& mcpInterface)
+    : mcpInterface(mcpInterface), values(0), directions(GPIO_PIN_MASK), synced(false), syncedGeneration(0),
+      valuesDirty(false), directionsDirty(false), pendingChanges(0), sentCount(0), mergedCount(0) {}
+
+// Relit l'état réel ; les modifications non envoyées sont perdues
+void GpioShadow::sync() {
+    values = mcpInterface.readGpioValues();
+    directions = mcpInterface.readGpioDirections();
+    sentCount += 2;
+    synced = true;
+    syncedGeneration = mcpInterface.connectionGeneration();
+    valuesDirty = false;
+    directionsDirty = false;
+    pendingChanges = 0;
+}
+
+void GpioShadow::ensureSynced() {
+    if (!synced || syncedGeneration != mcpInterface.connectionGeneration()) {
+        sync();
+    }
+}
+
+void GpioShadow::setPins(uint16_t mask, uint16_t newValues) {
+    ensureSynced();
+    mask &= GPIO_PIN_MASK;
+    values = (values & ~mask) | (newValues & mask);
+    valuesDirty = true;
+    ++pendingChanges;
+}
+
+void GpioShadow::togglePins(uint16_t mask) {
+    ensureSynced();
+    values ^= mask & GPIO_PIN_MASK;
+    valuesDirty = true;
+    ++pendingChanges;
+}
+
+void GpioShadow::setDirections(uint16_t mask, uint16_t inputs) {
+    ensureSynced();
+    mask &= GPIO_PIN_MASK;
+    directions = (directions & ~mask) | (inputs & mask);
+    directionsDirty = true;
+    ++pendingChanges;
+}
+
+uint16_t GpioShadow::readPins(uint16_t mask) {
+    ensureSynced();
+    mask &= GPIO_PIN_MASK;
+
+    // Les sorties sont servies depuis la copie locale, seules les entrées sont relues
+    uint16_t inputMask = mask & directions;
+    if (inputMask == 0) {
+        return values & mask;
+    }
+
+    uint16_t hardware = mcpInterface.readGpioValues();
+    ++sentCount;
+    return ((values & ~inputMask) | (hardware & inputMask)) & mask;
+}
+
+void GpioShadow::flush() {
+    if (pendingChanges > 1) {
+        mergedCount += pendingChanges - 1;
+    }
+
+    // Valeurs avant directions : une broche passée en sortie démarre au bon niveau
+    if (valuesDirty) {
+        mcpInterface.writeGpioValues(values);
+        ++sentCount;
+        valuesDirty = false;
+    }
+    if (directionsDirty) {
+        mcpInterface.writeGpioDirections(directions);
+        ++sentCount;
+        directionsDirty = false;
+    }
+    pendingChanges = 0;
+}
+
+unsigned long GpioShadow::commandsSent() const {
+    return sentCount;
+}
+
+unsigned long GpioShadow::changesMerged() const {
+    return mergedCount;
+}
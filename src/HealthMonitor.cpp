@@ -0,0 +1,91 @@
+#include "HealthMonitor.h"
+
+HealthMonitor::HealthMonitor(PotentiometerManager& manager, std::chrono::milliseconds period, CommandScheduler* scheduler)
+    : manager(manager), period(period), scheduler(scheduler), running(false), recoveryCount(0) {}
+
+HealthMonitor::~HealthMonitor() {
+    stop();
+}
+
+void HealthMonitor::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) return;
+    running = true;
+    worker = std::thread(&HealthMonitor::run, this);
+}
+
+void HealthMonitor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wakeUp.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+unsigned long HealthMonitor::recoveries() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return recoveryCount;
+}
+
+LatencyRecorder HealthMonitor::downtimes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return downtimeSamples;
+}
+
+// Retourne false si l'arrêt a été demandé pendant l'attente
+bool HealthMonitor::waitPeriod() {
+    std::unique_lock<std::mutex> lock(mutex);
+    wakeUp.wait_for(lock, period, [this] { return !running; });
+    return running;
+}
+
+bool HealthMonitor::probe() {
+    if (!scheduler) {
+        return !manager.faultDetected() && manager.probe();
+    }
+    bool healthy = false;
+    scheduler->submitOnce(Lane::Bulk, period, [&]() { healthy = !manager.faultDetected() && manager.probe(); }).get();
+    return healthy;
+}
+
+void HealthMonitor::reconnect() {
+    if (!scheduler) {
+        manager.reconnect();
+        return;
+    }
+    scheduler->submitOnce(Lane::Bulk, period, [&]() { manager.reconnect(); }).get();
+}
+
+void HealthMonitor::run() {
+    while (waitPeriod()) {
+        // Seul un sondage qui constate une erreur de transport déclenche la reconnexion :
+        // une exception (adaptateur occupé, file saturée) laisse l'état en place
+        bool healthy;
+        try {
+            healthy = probe();
+        } catch (const std::exception&) {
+            healthy = true;
+        }
+        if (healthy) continue;
+
+        // Reconnexion répétée à chaque période jusqu'au retour de l'adaptateur
+        auto lostAt = std::chrono::steady_clock::now();
+        bool recovered = false;
+        while (!recovered) {
+            try {
+                reconnect();
+                recovered = true;
+            } catch (const std::exception&) {
+                if (!waitPeriod()) return;
+            }
+        }
+
+        auto downtime = std::chrono::steady_clock::now() - lostAt;
+        std::lock_guard<std::mutex> lock(mutex);
+        ++recoveryCount;
+        downtimeSamples.add(std::chrono::duration<double, std::micro>(downtime).count());
+    }
+}
@@ -0,0 +1,430 @@
+#include "HidrawUring.h"
+
+#ifdef __linux__
+
+#include <stdexcept>
+#include <new>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#define HIDRAW_URING_WRITE 0
+#define HIDRAW_URING_READ 1
+#define HIDRAW_URING_TIMEOUT 2
+
+// Appels système bruts : pas de dépendance à liburing
+static int ioUringSetup(unsigned entries, struct io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, NULL, 0));
+}
+
+static int ioUringRegister(int fd, unsigned opcode, const void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+static unsigned nextPowerOfTwo(size_t n) {
+    unsigned power = 1;
+    while (power < n) power <<= 1;
+    return power;
+}
+
+HidrawUring::HidrawUring(size_t maxDevices, HidrawBackend preferred, std::chrono::milliseconds reportTimeout)
+    : capacity(maxDevices), activeBackend(HidrawBackend::Blocking), timeout(reportTimeout), syscallCount(0),
+      roundCount(0), arena(nullptr), arenaBytes(0), ringFd(-1), sqRing(nullptr), sqRingBytes(0), cqRing(nullptr),
+      cqRingBytes(0), sqes(nullptr), sqesBytes(0), sqHead(nullptr), sqTail(nullptr), sqMask(nullptr),
+      sqArray(nullptr), cqHead(nullptr), cqTail(nullptr), cqMask(nullptr), cqes(nullptr), registeredFiles(0) {
+    if (maxDevices == 0) {
+        throw std::runtime_error("Erreur : lot hidraw sans adaptateur.");
+    }
+
+    arenaBytes = (maxDevices * 2 * COMMAND_BUFFER_LENGTH + 4095) & ~static_cast<size_t>(4095);
+    arena = static_cast<uint8_t*>(std::aligned_alloc(4096, arenaBytes));
+    if (!arena) {
+        throw std::bad_alloc();
+    }
+    std::memset(arena, 0, arenaBytes);
+
+    reportTimespec.tv_sec = timeout.count() / 1000;
+    reportTimespec.tv_nsec = (timeout.count() % 1000) * 1000000;
+
+    if (preferred == HidrawBackend::Uring && setupRing(maxDevices)) {
+        activeBackend = HidrawBackend::Uring;
+    }
+}
+
+HidrawUring::~HidrawUring() {
+    teardownRing();
+    for (int fd : fds) {
+        close(fd);
+    }
+    std::free(arena);
+}
+
+bool HidrawUring::setupRing(size_t maxDevices) {
+    auto fail = [this](const char* step) {
+        reason = std::string(step) + " : " + std::strerror(errno);
+        teardownRing();
+        return false;
+    };
+
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ringFd = ioUringSetup(nextPowerOfTwo(maxDevices * HIDRAW_URING_SQES_PER_DEVICE), &params);
+    if (ringFd < 0) {
+        return fail("io_uring_setup");
+    }
+
+    sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) {
+        sqRingBytes = cqRingBytes = sqRingBytes > cqRingBytes ? sqRingBytes : cqRingBytes;
+    }
+
+    void* map = mmap(NULL, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (map == MAP_FAILED) {
+        return fail("mmap de l'anneau de soumission");
+    }
+    sqRing = map;
+    if (singleMap) {
+        cqRing = sqRing;
+    } else {
+        map = mmap(NULL, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (map == MAP_FAILED) {
+            return fail("mmap de l'anneau de complétion");
+        }
+        cqRing = map;
+    }
+    sqesBytes = params.sq_entries * sizeof(struct io_uring_sqe);
+    map = mmap(NULL, sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (map == MAP_FAILED) {
+        return fail("mmap des entrées de soumission");
+    }
+    sqes = static_cast<struct io_uring_sqe*>(map);
+
+    uint8_t* sq = static_cast<uint8_t*>(sqRing);
+    uint8_t* cq = static_cast<uint8_t*>(cqRing);
+    sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // Entrées de soumission à position fixe : l'indirection reste l'identité
+    for (unsigned i = 0; i < params.sq_entries; ++i) {
+        sqArray[i] = i;
+    }
+
+    // WRITE_FIXED/READ_FIXED (5.1), liens (5.3), LINK_TIMEOUT (5.5) ; la sonde elle-même date de 5.6
+    std::vector<uint8_t> probeBuffer(sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op), 0);
+    struct io_uring_probe* probe = reinterpret_cast<struct io_uring_probe*>(probeBuffer.data());
+    if (ioUringRegister(ringFd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+        return fail("noyau antérieur à 5.6 (IORING_REGISTER_PROBE)");
+    }
+    static const unsigned REQUIRED[] = {IORING_OP_WRITE_FIXED, IORING_OP_READ_FIXED, IORING_OP_LINK_TIMEOUT};
+    for (unsigned op : REQUIRED) {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+            errno = EOPNOTSUPP;
+            return fail("opération io_uring absente");
+        }
+    }
+
+    // Un seul tampon enregistré couvre tous les rapports (limité par RLIMIT_MEMLOCK avant 5.12)
+    struct iovec buffer;
+    buffer.iov_base = arena;
+    buffer.iov_len = arenaBytes;
+    if (ioUringRegister(ringFd, IORING_REGISTER_BUFFERS, &buffer, 1) < 0) {
+        return fail("enregistrement des tampons");
+    }
+    return true;
+}
+
+void HidrawUring::teardownRing() {
+    if (sqes) munmap(sqes, sqesBytes);
+    if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingBytes);
+    if (sqRing) munmap(sqRing, sqRingBytes);
+    if (ringFd >= 0) close(ringFd);
+    sqes = nullptr;
+    cqRing = nullptr;
+    sqRing = nullptr;
+    ringFd = -1;
+    registeredFiles = 0;
+}
+
+size_t HidrawUring::openDevice(const std::string& path) {
+    // Non bloquant : io_uring attend la réponse par poll au lieu d'occuper un thread noyau
+    int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Erreur : ouverture de " + path + " impossible (" + std::strerror(errno) + ").");
+    }
+    return addDevice(fd);
+}
+
+size_t HidrawUring::adoptDevice(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        close(fd);
+        throw std::runtime_error("Erreur : descripteur hidraw invalide.");
+    }
+    return addDevice(fd);
+}
+
+size_t HidrawUring::addDevice(int fd) {
+    if (fds.size() >= capacity) {
+        close(fd);
+        throw std::runtime_error("Erreur : lot hidraw complet.");
+    }
+    fds.push_back(fd);
+    return fds.size() - 1;
+}
+
+size_t HidrawUring::deviceCount() const {
+    return fds.size();
+}
+
+HidrawBackend HidrawUring::backend() const {
+    return activeBackend;
+}
+
+const std::string& HidrawUring::fallbackReason() const {
+    return reason;
+}
+
+unsigned long HidrawUring::syscalls() const {
+    return syscallCount;
+}
+
+unsigned long HidrawUring::rounds() const {
+    return roundCount;
+}
+
+uint8_t* HidrawUring::command(size_t device) {
+    return arena + device * 2 * COMMAND_BUFFER_LENGTH;
+}
+
+uint8_t* HidrawUring::response(size_t device) {
+    return command(device) + COMMAND_BUFFER_LENGTH;
+}
+
+int HidrawUring::enter(unsigned toSubmit, unsigned minComplete) {
+    for (;;) {
+        ++syscallCount;
+        int r = ioUringEnter(ringFd, toSubmit, minComplete, IORING_ENTER_GETEVENTS);
+        if (r >= 0) return r;
+        if (errno != EINTR) {
+            throw std::runtime_error(std::string("Erreur : io_uring_enter (") + std::strerror(errno) + ").");
+        }
+    }
+}
+
+void HidrawUring::exchange(const std::vector<size_t>& active, std::vector<int>& statuses) {
+    ++roundCount;
+    statuses.assign(active.size(), ERROR_UNABLE_TO_READ_FROM_DEVICE);
+    if (activeBackend == HidrawBackend::Uring) {
+        exchangeUring(active, statuses);
+    } else {
+        exchangeBlocking(active, statuses);
+    }
+}
+
+void HidrawUring::exchangeUring(const std::vector<size_t>& active, std::vector<int>& statuses) {
+    if (registeredFiles != fds.size()) {
+        if (registeredFiles > 0) {
+            ++syscallCount;
+            ioUringRegister(ringFd, IORING_UNREGISTER_FILES, NULL, 0);
+        }
+        ++syscallCount;
+        if (ioUringRegister(ringFd, IORING_REGISTER_FILES, fds.data(), static_cast<unsigned>(fds.size())) < 0) {
+            throw std::runtime_error(std::string("Erreur : enregistrement des descripteurs hidraw (") + std::strerror(errno) + ").");
+        }
+        registeredFiles = fds.size();
+    }
+
+    // Par adaptateur : écriture -> lecture -> délai, chaque maillon attendant le précédent
+    unsigned tail = *sqTail;
+    for (size_t k = 0; k < active.size(); ++k) {
+        size_t device = active[k];
+
+        struct io_uring_sqe* sqe = &sqes[tail++ & *sqMask];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_LINK;
+        sqe->fd = static_cast<int>(device);
+        sqe->addr = reinterpret_cast<uintptr_t>(command(device));
+        sqe->len = COMMAND_BUFFER_LENGTH;
+        sqe->buf_index = 0;
+        sqe->user_data = (k << 2) | HIDRAW_URING_WRITE;
+
+        sqe = &sqes[tail++ & *sqMask];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_LINK;
+        sqe->fd = static_cast<int>(device);
+        sqe->addr = reinterpret_cast<uintptr_t>(response(device));
+        sqe->len = RESPONSE_BUFFER_LENGTH;
+        sqe->buf_index = 0;
+        sqe->user_data = (k << 2) | HIDRAW_URING_READ;
+
+        sqe = &sqes[tail++ & *sqMask];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_LINK_TIMEOUT;
+        sqe->fd = -1;
+        sqe->addr = reinterpret_cast<uintptr_t>(&reportTimespec);
+        sqe->len = 1;
+        sqe->user_data = (k << 2) | HIDRAW_URING_TIMEOUT;
+    }
+    __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+    // Soumission et attente de toutes les complétions du tour en un appel
+    unsigned total = static_cast<unsigned>(active.size() * HIDRAW_URING_SQES_PER_DEVICE);
+    if (static_cast<unsigned>(enter(total, total)) != total) {
+        throw std::runtime_error("Erreur : soumission io_uring incomplète.");
+    }
+
+    std::vector<int> written(active.size(), 0);
+    std::vector<int> received(active.size(), -ECANCELED);
+    unsigned reaped = 0;
+    for (;;) {
+        unsigned head = *cqHead;
+        unsigned available = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        for (; head != available; ++head, ++reaped) {
+            const struct io_uring_cqe& cqe = cqes[head & *cqMask];
+            size_t k = static_cast<size_t>(cqe.user_data >> 2);
+            unsigned kind = static_cast<unsigned>(cqe.user_data & 0x3);
+            if (kind == HIDRAW_URING_WRITE) written[k] = cqe.res;
+            else if (kind == HIDRAW_URING_READ) received[k] = cqe.res;
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        if (reaped >= total) break;
+        enter(0, total - reaped);
+    }
+
+    for (size_t k = 0; k < active.size(); ++k) {
+        if (written[k] < 0) {
+            statuses[k] = ERROR_UNABLE_TO_WRITE_TO_DEVICE;
+        } else if (received[k] > 1) {
+            statuses[k] = response(active[k])[1];
+        }
+    }
+}
+
+void HidrawUring::exchangeBlocking(const std::vector<size_t>& active, std::vector<int>& statuses) {
+    // Toutes les écritures d'abord : les adaptateurs traitent leurs rapports en parallèle
+    std::vector<bool> written(active.size(), false);
+    for (size_t k = 0; k < active.size(); ++k) {
+        ++syscallCount;
+        written[k] = write(fds[active[k]], command(active[k]), COMMAND_BUFFER_LENGTH) >= 0;
+        if (!written[k]) statuses[k] = ERROR_UNABLE_TO_WRITE_TO_DEVICE;
+    }
+
+    // Puis, comme hid_read() bloquant : poll puis read
+    for (size_t k = 0; k < active.size(); ++k) {
+        if (!written[k]) continue;
+        struct pollfd pfd;
+        pfd.fd = fds[active[k]];
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ready;
+        do {
+            ++syscallCount;
+            ready = poll(&pfd, 1, static_cast<int>(timeout.count()));
+        } while (ready < 0 && errno == EINTR);
+        if (ready <= 0) continue;
+
+        ++syscallCount;
+        ssize_t n = read(pfd.fd, response(active[k]), RESPONSE_BUFFER_LENGTH);
+        if (n > 1) statuses[k] = response(active[k])[1];
+    }
+}
+
+void HidrawUring::spiTransfer(uint8_t* const* data, size_t length, std::vector<HidrawTransferResult>& results,
+                              const SPITransferPolicyDef& policy) {
+    if (length > sizeof(SPIDataTransferStatusDef::DataReceived)) {
+        throw std::runtime_error("Erreur : trames SPI trop longues pour un seul rapport.");
+    }
+
+    results.assign(fds.size(), HidrawTransferResult());
+    std::vector<SPITransferOutcomeDef> outcomes(fds.size(), SPITransferOutcomeDef());
+    std::vector<size_t> active;
+    for (size_t device = 0; device < fds.size(); ++device) {
+        active.push_back(device);
+    }
+    std::vector<size_t> remaining;
+    std::vector<size_t> cancel;
+    std::vector<int> statuses;
+    auto start = std::chrono::steady_clock::now();
+
+    while (!active.empty()) {
+        // Les données partent tant que le moteur ne les a pas acceptées, puis sondages vides
+        for (size_t device : active) {
+            uint8_t* cmd = command(device);
+            std::memset(cmd, 0, COMMAND_BUFFER_LENGTH);
+            cmd[0] = CMD_SPI_TRANSFER;
+            if (outcomes[device].Polls == 0) {
+                cmd[1] = static_cast<uint8_t>(length);
+                std::memcpy(cmd + 4, data[device], length);
+            }
+        }
+        exchange(active, statuses);
+        double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        remaining.clear();
+        for (size_t k = 0; k < active.size(); ++k) {
+            size_t device = active[k];
+            int r = statuses[k];
+            SPITransferOutcomeDef& outcome = outcomes[device];
+            HidrawTransferResult& result = results[device];
+            const uint8_t* rsp = response(device);
+
+            // Pas de pause sur une réponse « occupé » : les autres adaptateurs occupent le tour suivant
+            bool done = SPITransferAccountReply(outcome, policy, r, rsp[3], elapsed);
+            result.engineStatus = static_cast<uint8_t>(outcome.LastEngineStatus);
+            result.polls = outcome.Polls;
+            result.busyReplies = outcome.BusyReplies;
+            if (!done) {
+                remaining.push_back(device);
+                continue;
+            }
+
+            if (outcome.Outcome == SPI_TRANSFER_COMPLETED) {
+                size_t received = rsp[2] < length ? rsp[2] : length;
+                std::memcpy(data[device], rsp + 4, received);
+                result.status = 0;
+            } else if (outcome.Outcome == SPI_TRANSFER_FAILED) {
+                result.status = r;
+            } else {
+                result.status = ERROR_SPI_TRANSFER_TIMEOUT;
+                if (SPITransferNeedsCancel(outcome, policy)) {
+                    cancel.push_back(device);
+                }
+            }
+        }
+        active.swap(remaining);
+    }
+
+    // Transferts bloqués dans le moteur : libérés en un seul tour
+    if (!cancel.empty()) {
+        for (size_t device : cancel) {
+            std::memset(command(device), 0, COMMAND_BUFFER_LENGTH);
+            command(device)[0] = CMD_SPI_CANCEL;
+        }
+        exchange(cancel, statuses);
+        for (size_t k = 0; k < cancel.size(); ++k) {
+            results[cancel[k]].cancelled = statuses[k] == 0;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,65 @@
+#include "LatencyRecorder.h"
+#include <algorithm>
+#include <cmath>
+
+LatencyRecorder::LatencyRecorder() : next(0), sortedValid(true), total(0), sum(0.0), lowest(0.0), highest(0.0) {}
+
+void LatencyRecorder::add(double micros) {
+    if (window.size() < LATENCY_RECORDER_WINDOW) {
+        window.push_back(micros);
+    } else {
+        window[next] = micros;
+        next = (next + 1) % LATENCY_RECORDER_WINDOW;
+    }
+    lowest = total == 0 ? micros : std::min(lowest, micros);
+    highest = total == 0 ? micros : std::max(highest, micros);
+    ++total;
+    sum += micros;
+    sortedValid = false;
+}
+
+void LatencyRecorder::clear() {
+    window.clear();
+    sorted.clear();
+    next = 0;
+    sortedValid = true;
+    total = 0;
+    sum = 0.0;
+    lowest = 0.0;
+    highest = 0.0;
+}
+
+size_t LatencyRecorder::count() const {
+    return total;
+}
+
+double LatencyRecorder::mean() const {
+    return total == 0 ? 0.0 : sum / total;
+}
+
+double LatencyRecorder::min() const {
+    return lowest;
+}
+
+double LatencyRecorder::max() const {
+    return highest;
+}
+
+// Tri différé : la fenêtre n'est triée qu'à la première lecture de la distribution
+void LatencyRecorder::sortSamples() const {
+    if (!sortedValid) {
+        sorted = window;
+        std::sort(sorted.begin(), sorted.end());
+        sortedValid = true;
+    }
+}
+
+double LatencyRecorder::percentile(double p) const {
+    if (window.empty()) return 0.0;
+    sortSamples();
+
+    // Rang le plus proche
+    double rank = std::ceil(p / 100.0 * sorted.size());
+    size_t index = rank < 1.0 ? 0 : static_cast<size_t>(rank) - 1;
+    return sorted[std::min(index, sorted.size() - 1)];
+}
@@ -1,96 +1,631 @@
 #include "MCP2210Interface.h"
+#include "DevicePathCache.h"
 #include <stdexcept>
 #include <cstring>
+#include <thread>
 
-MCP2210Interface::MCP2210Interface() {
-    handle = InitMCP2210();
+MCP2210Interface::MCP2210Interface(const std::string& pathCacheFile)
+    : pathCacheFile(pathCacheFile), openStart(std::chrono::steady_clock::now()), timing{false, "", 0.0, -1.0},
+      faulted(false), generation(0), spiSettingsKnown(false), spiSettings(), policy(DefaultSPITransferPolicy()),
+      lastOutcome(), busOwner(SPI_BUS_OWNER_UNKNOWN), externalMaster(false), arbitrationTimeout(0),
+      transactionDepth(0) {
+    openDevice();
     if (!handle) {
         throw std::runtime_error("Impossible d'initialiser le MCP2210.");
     }
+    timing.openMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - openStart).count();
+}
+
+static std::string narrowSerial(const std::wstring& serial) {
+    // Le numéro de série du MCP2210 est en ASCII
+    std::string result;
+    for (wchar_t c : serial) {
+        result += static_cast<char>(c);
+    }
+    return result;
+}
+
+// Chemin mémorisé d'abord (un ioctl et une vérification du numéro de série),
+// énumération des périphériques HID sinon, puis mémorisation du nouveau chemin
+void MCP2210Interface::openDevice() {
+    handle = nullptr;
+    timing.cachedPath = false;
+
+    std::unique_ptr<DevicePathCache> cache;
+    if (!pathCacheFile.empty()) {
+        cache.reset(new DevicePathCache(pathCacheFile));
+        std::string wanted = serial.empty() ? cache->lastSerial() : narrowSerial(serial);
+        std::string devicePath = cache->lookup(wanted);
+        if (!devicePath.empty()) {
+            std::wstring wideSerial(wanted.begin(), wanted.end());
+            handle = InitMCP2210ByPath(devicePath.c_str(), MCP2210_VID, MCP2210_PID, wideSerial.c_str());
+            if (handle && !IsMCP2210VirtualDevice(handle)) {
+                serial = wideSerial;
+                timing.cachedPath = true;
+                timing.devicePath = devicePath;
+            }
+        }
+    }
+    if (!handle) {
+        handle = serial.empty() ? InitMCP2210() : InitMCP2210(&serial[0]);
+        if (!handle) return;
+    }
+
+    // Numéro de série mémorisé pour rouvrir le même adaptateur après une déconnexion
+    if (IsMCP2210VirtualDevice(handle)) {
+        serial = L"SIMULATEUR";
+        timing.devicePath.clear();
+        return;
+    }
+    wchar_t serialBuffer[64] = {0};
+    if (serial.empty() && hid_get_serial_number_string(handle, serialBuffer, 64) >= 0) {
+        serial = serialBuffer;
+    }
+
+    if (cache && !timing.cachedPath && !serial.empty()) {
+        struct hid_device_info* info = hid_get_device_info(handle);
+        if (info && info->path) {
+            timing.devicePath = info->path;
+            cache->remember(narrowSerial(serial), info->path);
+            try {
+                cache->save();
+            } catch (const std::exception&) {
+                // Cache facultatif : la prochaine ouverture énumérera à nouveau
+            }
+        }
+    }
 }
 
 MCP2210Interface::~MCP2210Interface() {
-    ReleaseMCP2210(handle);
+    if (handle) {
+        ReleaseMCP2210(handle);
+    }
 }
 
-void MCP2210Interface::sendSPICommand(const std::vector<uint8_t>& commandFrames, std::vector<uint8_t>& responseFrames) {
-    size_t totalBytes = commandFrames.size() + NUM_POTS * 2; // Ajout de trames vides pour récupérer toutes les réponses.
-    std::vector<uint8_t> extendedCommandFrames(totalBytes, 0x00); // Commandes + trames vides
-    std::copy(commandFrames.begin(), commandFrames.end(), extendedCommandFrames.begin());
+// responseFrames reçoit length + NUM_POTS * 2 octets
+Expected<void> MCP2210Interface::sendSPICommand(const uint8_t* commandFrames, size_t length, uint8_t* responseFrames) {
+    size_t totalBytes = length + NUM_POTS * 2; // Ajout de trames vides pour récupérer toutes les réponses.
+    if (totalBytes > sizeof(SPIDataTransferStatusDef::DataReceived)) {
+        return unexpected(ErrorCode(ErrorKind::FrameTooLong, "Erreur : trames SPI trop longues pour un seul rapport."));
+    }
 
-    uint8_t cmdBuffer[COMMAND_BUFFER_LENGTH] = {0};
-    uint8_t responseBuffer[COMMAND_BUFFER_LENGTH] = {0};
+    uint8_t extendedCommandFrames[COMMAND_BUFFER_LENGTH] = {0}; // Commandes + trames vides
+    std::memcpy(extendedCommandFrames, commandFrames, length);
 
-    std::memcpy(cmdBuffer, extendedCommandFrames.data(), extendedCommandFrames.size());
+    return tryTransferFrames(extendedCommandFrames, totalBytes, responseFrames);
+}
 
-    SPIDataTransferStatusDef status = SPISendReceive(handle, cmdBuffer, extendedCommandFrames.size(), extendedCommandFrames.size());
+MCP2210Interface::Transaction::Transaction(MCP2210Interface& owner) : Transaction(owner, std::nothrow) {
+    if (!error.ok()) {
+        throwError(error);
+    }
+}
 
-    if (status.ErrorCode != OPERATION_SUCCESSFUL) {
-        throw std::runtime_error("Erreur lors du transfert SPI.");
+MCP2210Interface::Transaction::Transaction(MCP2210Interface& owner, std::nothrow_t)
+    : owner(owner), deviceLock(owner.deviceMutex), nested(owner.transactionDepth > 0), adapterLocked(false) {
+    ++owner.transactionDepth;
+    if (!owner.handle) {
+        error = ErrorCode(ErrorKind::Disconnected, "Erreur : MCP2210 déconnecté.");
+        return;
     }
+    // Transaction imbriquée : le verrou et le bus sont déjà à nous
+    if (nested || !owner.adapterLock) return;
 
-    responseFrames.assign(status.DataReceived, status.DataReceived + extendedCommandFrames.size());
+    if (!owner.adapterLock->tryAcquire()) {
+        error = ErrorCode(ErrorKind::AdapterBusy, "Erreur : adaptateur occupé par un autre processus.");
+        return;
+    }
+    adapterLocked = true;
+    if (owner.externalMaster) {
+        error = owner.waitForBus();
+        if (!error.ok()) {
+            owner.adapterLock->release();
+            adapterLocked = false;
+        }
+    }
 }
 
-std::vector<uint16_t> MCP2210Interface::readCurrentResistances() {
-    std::vector<uint8_t> commandFrames(NUM_POTS * 2, 0x08); // Commande de lecture
-    std::vector<uint8_t> responseFrames;
+const ErrorCode& MCP2210Interface::Transaction::failure() const {
+    return error;
+}
 
-    sendSPICommand(commandFrames, responseFrames);
+MCP2210Interface::Transaction::~Transaction() {
+    --owner.transactionDepth;
+    if (!adapterLocked) return;
 
-    // Décaler la réponse pour ignorer les trames initiales vides
-    size_t offset = NUM_POTS * 2; // Nombre de trames vides initiales
-    if (responseFrames.size() < offset + NUM_POTS * 2) {
-        throw std::runtime_error("Erreur : trame SPI insuffisante en réponse.");
+    if (owner.externalMaster) {
+        try {
+            owner.releaseBusIfRequested();
+        } catch (...) {
+            // La libération du bus est un geste de courtoisie : l'échec n'annule pas la transaction
+        }
     }
+    owner.adapterLock->release();
+}
 
-    std::vector<uint16_t> resistances(NUM_POTS);
-    for (int i = 0; i < NUM_POTS; ++i) {
-        resistances[i] = (responseFrames[offset + i * 2] << 8) | responseFrames[offset + i * 2 + 1];
+void MCP2210Interface::enableArbitration(std::chrono::milliseconds timeout, bool useExternalMaster) {
+    adapterLock.reset(new AdapterLock(serialNumber(), timeout));
+    externalMaster = useExternalMaster;
+    arbitrationTimeout = timeout;
+}
+
+const AdapterLock* MCP2210Interface::arbitration() const {
+    return adapterLock.get();
+}
+
+// Attente que le maître SPI externe rende le bus
+ErrorCode MCP2210Interface::waitForBus() {
+    auto deadline = std::chrono::steady_clock::now() + arbitrationTimeout;
+    while (true) {
+        ChipStatusDef status = GetChipStatus(handle);
+        if (status.ErrorCode != OPERATION_SUCCESSFUL) {
+            return ErrorCode::fromLibrary(status.ErrorCode, "Erreur : lecture de l'état du MCP2210 impossible.");
+        }
+        busOwner = status.SPIBusCurrentOwner;
+        if (status.SPIBusCurrentOwner != SPI_BUS_OWNER_EXTERNAL_MASTER) {
+            return ErrorCode();
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return ErrorCode(ErrorKind::ExternalMaster, "Erreur : bus SPI occupé par un maître externe.");
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
     }
+}
 
-    return resistances;
+// Rend le bus au maître externe s'il l'a demandé pendant la transaction
+void MCP2210Interface::releaseBusIfRequested() {
+    ChipStatusDef status = GetChipStatus(handle);
+    if (status.ErrorCode == OPERATION_SUCCESSFUL && status.SPIBusReleaseExtReqStat == SPI_BUS_RELEASE_EXT_REQ_PENDING) {
+        RequestSPIBusRelease(handle, 0x0);
+    }
+}
+
+std::vector<uint16_t> MCP2210Interface::readCurrentResistances() {
+    return tryReadCurrentResistances().valueOrThrow();
 }
 
 std::vector<uint16_t> MCP2210Interface::readMemoryResistances() {
-    std::vector<uint8_t> commandFrames(NUM_POTS * 2, 0x14); // Commande de lecture mémoire
-    std::vector<uint8_t> responseFrames;
+    return tryReadMemoryResistances().valueOrThrow();
+}
 
-    sendSPICommand(commandFrames, responseFrames);
+Expected<std::vector<uint16_t>> MCP2210Interface::tryReadCurrentResistances() {
+    return readChainFrames(0x08); // Commande de lecture
+}
 
-    // Décaler la réponse pour ignorer les trames initiales vides
-    size_t offset = NUM_POTS * 2;
-    if (responseFrames.size() < offset + NUM_POTS * 2) {
-        throw std::runtime_error("Erreur : trame SPI insuffisante en réponse.");
+Expected<std::vector<uint16_t>> MCP2210Interface::tryReadMemoryResistances() {
+    return readChainFrames(0x14); // Commande de lecture mémoire
+}
+
+Expected<std::vector<uint16_t>> MCP2210Interface::readChainFrames(uint8_t command) {
+    uint8_t commandFrames[CHAIN_FRAME_LENGTH];
+    uint8_t responseFrames[CHAIN_TRANSFER_LENGTH];
+    std::memset(commandFrames, command, sizeof(commandFrames));
+
+    Expected<void> sent = sendSPICommand(commandFrames, sizeof(commandFrames), responseFrames);
+    if (!sent) {
+        return unexpected(sent.error());
     }
 
+    // Décaler la réponse pour ignorer les trames initiales vides
+    const uint8_t* echo = responseFrames + CHAIN_FRAME_LENGTH;
     std::vector<uint16_t> resistances(NUM_POTS);
     for (int i = 0; i < NUM_POTS; ++i) {
-        resistances[i] = (responseFrames[offset + i * 2] << 8) | responseFrames[offset + i * 2 + 1];
+        resistances[i] = (echo[i * 2] << 8) | echo[i * 2 + 1];
     }
 
     return resistances;
 }
 
-void MCP2210Interface::programResistances(const std::vector<uint16_t>& values) {
+Expected<void> MCP2210Interface::checkValues(const std::vector<uint16_t>& values) {
     if (values.size() != NUM_POTS) {
-        throw std::runtime_error("Erreur : le nombre de valeurs ne correspond pas au nombre de potentiomètres.");
+        return unexpected(ErrorCode(ErrorKind::InvalidArgument,
+                                    "Erreur : le nombre de valeurs ne correspond pas au nombre de potentiomètres."));
     }
+    if (!MainChainLayout::valuesInRange(values.data())) {
+        return unexpected(ErrorCode(ErrorKind::InvalidArgument, "Erreur : valeur RDAC hors limites (max 1023)."));
+    }
+    return Expected<void>();
+}
 
-    std::vector<uint8_t> commandFrames(NUM_POTS * 2);
-    for (int i = 0; i < NUM_POTS; ++i) {
-        commandFrames[i * 2] = 0x04 | ((values[i] >> 8) & 0x0F); // Commande d'écriture
-        commandFrames[i * 2 + 1] = values[i] & 0xFF;             // Valeur faible
+void MCP2210Interface::encodeWriteFrames(const uint16_t* values, uint8_t* frames) {
+    MainChainLayout::encodeWrite(values, frames);
+}
+
+void MCP2210Interface::decodeWriteFrames(const uint8_t* frames, uint16_t* values) {
+    MainChainLayout::decodeValues(frames, values);
+}
+
+void MCP2210Interface::transferFrames(const uint8_t* frames, size_t length, uint8_t* responseFrames) {
+    tryTransferFrames(frames, length, responseFrames).valueOrThrow();
+}
+
+Expected<void> MCP2210Interface::tryTransferFrames(const uint8_t* frames, size_t length, uint8_t* responseFrames) {
+    if (length > sizeof(SPIDataTransferStatusDef::DataReceived)) {
+        return unexpected(ErrorCode(ErrorKind::FrameTooLong, "Erreur : trames SPI trop longues pour un seul rapport."));
+    }
+
+    uint8_t cmdBuffer[COMMAND_BUFFER_LENGTH] = {0};
+    std::memcpy(cmdBuffer, frames, length);
+
+    Transaction transaction(*this, std::nothrow);
+    if (!transaction.failure().ok()) {
+        return unexpected(transaction.failure());
+    }
+    if (mainChainSelector) {
+        try {
+            mainChainSelector();
+        } catch (const std::exception&) {
+            return unexpected(ErrorCode(ErrorKind::UsbError, "Erreur : rétablissement des CS de la chaîne principale impossible."));
+        }
+    }
+
+    const SPITransferOutcomeDef outcome = SPISendReceiveBounded(handle, cmdBuffer, length, length, transferPolicy());
+    {
+        std::lock_guard<std::mutex> lock(outcomeMutex);
+        lastOutcome = outcome;
+    }
+    const SPIDataTransferStatusDef& status = outcome.Status;
+    if (outcome.SPIBusCurrentOwner != SPI_BUS_OWNER_UNKNOWN) {
+        busOwner = outcome.SPIBusCurrentOwner;
+    }
+    if (outcomeObserver) {
+        outcomeObserver(outcome);
+    }
+    if (transferObserver && outcome.Outcome == SPI_TRANSFER_COMPLETED) {
+        transferObserver(length, outcome);
+    }
+    if (timing.firstTransferMicros < 0 && outcome.Outcome == SPI_TRANSFER_COMPLETED) {
+        timing.firstTransferMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - openStart).count();
+    }
+
+    if (outcome.Outcome != SPI_TRANSFER_COMPLETED) {
+        ErrorCode error;
+        if (outcome.Outcome == SPI_TRANSFER_BUS_UNAVAILABLE) {
+            error = ErrorCode(ErrorKind::ExternalMaster, "Erreur : bus SPI occupé par un maître externe.",
+                              status.ErrorCode, outcome.LastEngineStatus);
+        } else if (outcome.Outcome == SPI_TRANSFER_TIMED_OUT) {
+            error = ErrorCode(ErrorKind::Timeout, outcome.Cancelled ? "Erreur : transfert SPI expiré, annulé."
+                                                                    : "Erreur : transfert SPI expiré.",
+                              status.ErrorCode, outcome.LastEngineStatus);
+        } else {
+            if (status.ErrorCode < 0) {
+                faulted = true; // Erreur d'écriture/lecture USB : adaptateur probablement déconnecté
+            }
+            error = ErrorCode::fromLibrary(status.ErrorCode, "Erreur lors du transfert SPI.", outcome.LastEngineStatus);
+        }
+        error.deviceStatus = static_cast<uint8_t>(outcome.LastDeviceStatus);
+        return unexpected(error);
+    }
+    if (status.NumberOfBytesReceived < length) {
+        return unexpected(ErrorCode(ErrorKind::ShortResponse, "Erreur : trame SPI insuffisante en réponse.",
+                                    0, status.SPIEngineStatus));
     }
 
-    std::vector<uint8_t> responseFrames(NUM_POTS * 2);
-    sendSPICommand(commandFrames, responseFrames);
+    if (responseFrames) {
+        std::memcpy(responseFrames, status.DataReceived, length);
+    }
+    return Expected<void>();
+}
+
+void MCP2210Interface::programResistances(const std::vector<uint16_t>& values) {
+    tryProgramResistances(values).valueOrThrow();
+}
+
+Expected<void> MCP2210Interface::tryProgramResistances(const std::vector<uint16_t>& values) {
+    Expected<void> valid = checkValues(values);
+    if (!valid) {
+        return valid;
+    }
+
+    uint8_t commandFrames[CHAIN_FRAME_LENGTH];
+    encodeWriteFrames(values.data(), commandFrames);
+
+    uint8_t responseFrames[CHAIN_TRANSFER_LENGTH];
+    Expected<void> sent = sendSPICommand(commandFrames, sizeof(commandFrames), responseFrames);
+    if (sent) {
+        setReplayValues(values.data());
+    }
+    return sent;
+}
+
+std::bitset<NUM_POTS> MCP2210Interface::programAndVerify(const std::vector<uint16_t>& values) {
+    return tryProgramAndVerify(values).valueOrThrow();
+}
+
+Expected<std::bitset<NUM_POTS>> MCP2210Interface::tryProgramAndVerify(const std::vector<uint16_t>& values) {
+    Expected<void> valid = checkValues(values);
+    if (!valid) {
+        return unexpected(valid.error());
+    }
+
+    // Trames d'écriture, puis trames de lecture, puis trames vides pour récupérer l'écho
+    uint8_t commandFrames[CHAIN_FRAME_LENGTH * 3] = {0};
+    uint8_t responseFrames[CHAIN_FRAME_LENGTH * 3] = {0};
+    encodeWriteFrames(values.data(), commandFrames);
+    std::memset(commandFrames + CHAIN_FRAME_LENGTH, 0x08, CHAIN_FRAME_LENGTH); // Commande de lecture
+
+    Expected<void> sent;
+    if (sizeof(commandFrames) <= sizeof(SPIDataTransferStatusDef::DataReceived)) {
+        // Toute la séquence tient dans un seul rapport : une seule fenêtre CS
+        sent = tryTransferFrames(commandFrames, sizeof(commandFrames), responseFrames);
+    } else {
+        // Chaîne trop longue : écriture puis lecture, sans trames vides après l'écriture
+        sent = tryTransferFrames(commandFrames, CHAIN_FRAME_LENGTH);
+        if (sent) {
+            sent = tryTransferFrames(commandFrames + CHAIN_FRAME_LENGTH, CHAIN_FRAME_LENGTH * 2,
+                                     responseFrames + CHAIN_FRAME_LENGTH);
+        }
+    }
+    if (!sent) {
+        return unexpected(sent.error());
+    }
+
+    setReplayValues(values.data());
+
+    // Comparaison sur l'hôte des valeurs RDAC renvoyées avec les consignes telles que demandées
+    const uint8_t* echo = responseFrames + CHAIN_FRAME_LENGTH * 2;
+    std::bitset<NUM_POTS> mismatches;
+    for (int i = 0; i < NUM_POTS; ++i) {
+        uint16_t value = (echo[i * 2] << 8) | echo[i * 2 + 1];
+        mismatches[i] = (value & RDAC_VALUE_MASK) != values[i];
+    }
+    return mismatches;
 }
 
 void MCP2210Interface::storeResistancesToMemory() {
-    std::vector<uint8_t> commandFrames(NUM_POTS * 2, 0x0C); // Commande de stockage
-    std::vector<uint8_t> responseFrames(NUM_POTS * 2);
+    tryStoreResistancesToMemory(std::bitset<NUM_POTS>().set()).valueOrThrow();
+}
+
+void MCP2210Interface::storeResistancesToMemory(const std::bitset<NUM_POTS>& pots) {
+    tryStoreResistancesToMemory(pots).valueOrThrow();
+}
+
+Expected<void> MCP2210Interface::tryStoreResistancesToMemory(const std::bitset<NUM_POTS>& pots) {
+    // Commande de stockage pour les potentiomètres choisis, NOP (0x00) pour les autres
+    uint8_t commandFrames[CHAIN_FRAME_LENGTH] = {0};
+    for (int i = 0; i < NUM_POTS; ++i) {
+        if (pots[i]) {
+            commandFrames[i * 2] = 0x0C;
+            commandFrames[i * 2 + 1] = 0x0C;
+        }
+    }
+    uint8_t responseFrames[CHAIN_TRANSFER_LENGTH];
+
+    return sendSPICommand(commandFrames, sizeof(commandFrames), responseFrames);
+}
+
+void MCP2210Interface::setTransferObserver(std::function<void(size_t, const SPITransferOutcomeDef&)> observer) {
+    std::lock_guard<std::recursive_mutex> lock(deviceMutex);
+    transferObserver = std::move(observer);
+}
+
+void MCP2210Interface::setMainChainSelector(std::function<void()> selector) {
+    std::lock_guard<std::recursive_mutex> lock(deviceMutex);
+    mainChainSelector = std::move(selector);
+}
+
+void MCP2210Interface::setTransferPolicy(const SPITransferPolicyDef& newPolicy) {
+    // Sans aucune limite, un bus tenu par un autre maître bloquerait le transfert indéfiniment
+    if (newPolicy.MaxPolls == 0 && newPolicy.TimeoutMicros == 0) {
+        throw std::invalid_argument("Erreur : un transfert SPI doit être limité en délai ou en sondages.");
+    }
+    std::lock_guard<std::mutex> lock(outcomeMutex);
+    policy = newPolicy;
+}
+
+SPITransferPolicyDef MCP2210Interface::transferPolicy() const {
+    std::lock_guard<std::mutex> lock(outcomeMutex);
+    return policy;
+}
+
+void MCP2210Interface::setOutcomeObserver(std::function<void(const SPITransferOutcomeDef&)> observer) {
+    std::lock_guard<std::recursive_mutex> lock(deviceMutex);
+    outcomeObserver = std::move(observer);
+}
+
+SPITransferOutcomeDef MCP2210Interface::lastTransferOutcome() const {
+    std::lock_guard<std::mutex> lock(outcomeMutex);
+    return lastOutcome;
+}
+
+unsigned int MCP2210Interface::lastBusOwner() const {
+    return busOwner;
+}
+
+std::string MCP2210Interface::serialNumber() {
+    if (serial.empty()) {
+        throw std::runtime_error("Erreur : lecture du numéro de série impossible.");
+    }
+    return narrowSerial(serial);
+}
+
+OpenTiming MCP2210Interface::openTiming() const {
+    return timing;
+}
+
+void MCP2210Interface::configureTriggerPin(unsigned int countMode) {
+    Transaction transaction(*this);
+    ChipSettingsDef settings = GetChipSettings(handle);
+    if (settings.ErrorCode != OPERATION_SUCCESSFUL) {
+        throw std::runtime_error("Erreur : lecture de la configuration du MCP2210 impossible.");
+    }
+
+    settings.GP[6].PinDesignation = GP_PIN_DESIGNATION_DEDICATED;
+    settings.DedicatedFunctionInterruptPinMode = countMode;
+
+    if (SetChipSettings(handle, settings) != OPERATION_SUCCESSFUL) {
+        throw std::runtime_error("Erreur : configuration de la broche GP6 impossible.");
+    }
+}
+
+unsigned int MCP2210Interface::readInterruptEvents(bool reset) {
+    Transaction transaction(*this);
+    ExternalInterruptPinStatusDef status = GetNumOfEventsFromInterruptPin(handle, reset ? 0x0 : 0x1);
+    if (status.ErrorCode != OPERATION_SUCCESSFUL) {
+        throw std::runtime_error("Erreur : lecture du compteur d'interruptions impossible.");
+    }
+    return status.InterruptEventCounter;
+}
+
+uint16_t MCP2210Interface::readGpioValues() {
+    Transaction transaction(*this);
+    unsigned int bits = 0;
+    if (GetGPIOPinValueBits(handle, &bits) != OPERATION_SUCCESSFUL) {
+        throw std::runtime_error("Erreur : lecture des GPIO impossible.");
+    }
+    return static_cast<uint16_t>(bits);
+}
+
+void MCP2210Interface::writeGpioValues(uint16_t bits) {
+    Transaction transaction(*this);
+    if (SetGPIOPinValueBits(handle, bits) != OPERATION_SUCCESSFUL) {
+        throw std::runtime_error("Erreur : écriture des GPIO impossible.");
+    }
+}
+
+uint16_t MCP2210Interface::readGpioDirections() {
+    Transaction transaction(*this);
+    unsigned int bits = 0;
+    if (GetGPIOPinDirectionBits(handle, &bits) != OPERATION_SUCCESSFUL) {
+        throw std::runtime_error("Erreur : lecture de la direction des GPIO impossible.");
+    }
+    return static_cast<uint16_t>(bits);
+}
+
+void MCP2210Interface::writeGpioDirections(uint16_t bits) {
+    Transaction transaction(*this);
+    if (SetGPIOPinDirectionBits(handle, bits) != OPERATION_SUCCESSFUL) {
+        throw std::runtime_error("Erreur : écriture de la direction des GPIO impossible.");
+    }
+}
+
+uint8_t MCP2210Interface::readEeprom(uint8_t address) {
+    Transaction transaction(*this);
+    byte value = 0;
+    if (ReadEEPROM(handle, address, &value) != OPERATION_SUCCESSFUL) {
+        throw std::runtime_error("Erreur : lecture de l'EEPROM impossible.");
+    }
+    return value;
+}
+
+ChipStatusDef MCP2210Interface::chipStatus() {
+    return tryChipStatus().valueOrThrow();
+}
+
+Expected<ChipStatusDef> MCP2210Interface::tryChipStatus() {
+    Transaction transaction(*this, std::nothrow);
+    if (!transaction.failure().ok()) {
+        return unexpected(transaction.failure());
+    }
+    ChipStatusDef status = GetChipStatus(handle);
+    if (status.ErrorCode != OPERATION_SUCCESSFUL) {
+        return unexpected(ErrorCode::fromLibrary(status.ErrorCode, "Erreur : lecture de l'état du MCP2210 impossible."));
+    }
+    return status;
+}
+
+SPITransferSettingsDef MCP2210Interface::readSpiSettings() {
+    Transaction transaction(*this);
+    SPITransferSettingsDef settings = GetSPITransferSettings(handle);
+    if (settings.ErrorCode != OPERATION_SUCCESSFUL) {
+        throw std::runtime_error("Erreur : lecture des paramètres SPI impossible.");
+    }
+    spiSettings = settings;
+    spiSettingsKnown = true;
+    return settings;
+}
+
+void MCP2210Interface::writeSpiSettings(const SPITransferSettingsDef& settings) {
+    Transaction transaction(*this);
+    if (SetSPITransferSettings(handle, settings) != OPERATION_SUCCESSFUL) {
+        throw std::runtime_error("Erreur : écriture des paramètres SPI impossible.");
+    }
+    spiSettings = settings;
+    spiSettingsKnown = true;
+}
+
+void MCP2210Interface::designateChipSelects(uint16_t csMask) {
+    Transaction transaction(*this);
+    ChipSettingsDef settings = GetChipSettings(handle);
+    if (settings.ErrorCode != OPERATION_SUCCESSFUL) {
+        throw std::runtime_error("Erreur : lecture de la configuration du MCP2210 impossible.");
+    }
+
+    bool changed = false;
+    for (int i = 0; i < 9; ++i) {
+        if ((csMask >> i) & 0x1 && settings.GP[i].PinDesignation != GP_PIN_DESIGNATION_CS) {
+            settings.GP[i].PinDesignation = GP_PIN_DESIGNATION_CS;
+            changed = true;
+        }
+    }
+
+    if (changed && SetChipSettings(handle, settings) != OPERATION_SUCCESSFUL) {
+        throw std::runtime_error("Erreur : configuration des broches CS impossible.");
+    }
+}
+
+// Sondage de basse priorité : si le périphérique est occupé, il est vivant et le sondage est sauté.
+// Un verrou tenu par un autre processus ou un bus gardé par un maître externe ne sont pas des
+// déconnexions : seule une erreur USB (code négatif, ENODEV de hidraw compris) en est une.
+bool MCP2210Interface::probe() {
+    std::unique_lock<std::recursive_mutex> busy(deviceMutex, std::try_to_lock);
+    if (!busy.owns_lock()) {
+        return !faulted;
+    }
+
+    Transaction transaction(*this, std::nothrow);
+    const ErrorCode& failure = transaction.failure();
+    if (failure.kind == ErrorKind::Disconnected) {
+        return false;
+    }
+    if (!failure.ok()) {
+        if (failure.libraryCode < 0) {
+            faulted = true;
+        }
+        return !faulted;
+    }
+    ChipStatusDef status = GetChipStatus(handle);
+    if (status.ErrorCode < 0) {
+        faulted = true;
+    } else if (status.ErrorCode == OPERATION_SUCCESSFUL) {
+        busOwner = status.SPIBusCurrentOwner;
+    }
+    return !faulted;
+}
+
+bool MCP2210Interface::faultDetected() const {
+    return faulted;
+}
+
+void MCP2210Interface::reconnect() {
+    std::lock_guard<std::recursive_mutex> lock(deviceMutex);
+
+    if (handle && !IsMCP2210VirtualDevice(handle)) {
+        hid_close(handle);
+    }
+    handle = nullptr;
+
+    openDevice();
+    if (!handle) {
+        throw std::runtime_error("Erreur : reconnexion au MCP2210 impossible.");
+    }
+    faulted = false;
+    ++generation;
+
+    // Le MCP2210 est revenu à ses paramètres de mise sous tension : on restaure les nôtres
+    if (spiSettingsKnown) {
+        writeSpiSettings(spiSettings);
+    }
+    if (!lastProgrammed.empty()) {
+        programResistances(lastProgrammed);
+    }
+}
 
-    sendSPICommand(commandFrames, responseFrames);
+unsigned long MCP2210Interface::connectionGeneration() const {
+    return generation;
 }
 
+void MCP2210Interface::setReplayValues(const uint16_t* values) {
+    std::lock_guard<std::recursive_mutex> lock(deviceMutex);
+    lastProgrammed.assign(values, values + NUM_POTS);
+}
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "MCP2210Simulator.h"
+#include <stdexcept>
+#include <cstring>
+#include <thread>
+
+MCP2210Simulator::MCP2210Simulator(size_t potCount, std::chrono::microseconds reportLatency)
+    : rdac(potCount, 0x200), memory(potCount, 0x200), spiSettings(), gpioValues(0), gpioDirections(GPIO_PIN_MASK),
+      interruptEvents(0), transferPending(false), pendingSpiMicros(0.0), latency(reportLatency), reportCount(0),
+      installed(false), loopback(&MCP2210Simulator::handleReport, this) {
+    if (potCount == 0 || potCount * 2 > sizeof(SPIDataTransferStatusDef::DataReceived)) {
+        throw std::runtime_error("Erreur : longueur de chaîne simulée invalide.");
+    }
+
+    // Paramètres de mise sous tension : 1 MHz, mode 1, CS sur GP0
+    spiSettings.BitRate = 1000000;
+    spiSettings.IdleChipSelectValue = GPIO_PIN_MASK;
+    spiSettings.ActiveChipSelectValue = GPIO_PIN_MASK & ~0x1;
+    spiSettings.BytesPerSPITransfer = CHAIN_TRANSFER_LENGTH;
+    spiSettings.SPIMode = 1;
+    std::memset(designations, GP_PIN_DESIGNATION_GPIO, sizeof(designations));
+    designations[0] = GP_PIN_DESIGNATION_CS;
+    designations[6] = GP_PIN_DESIGNATION_DEDICATED; // Compteur d'interruptions
+    std::memset(eeprom, 0xFF, sizeof(eeprom));
+}
+
+MCP2210Simulator::~MCP2210Simulator() {
+    uninstall();
+}
+
+void MCP2210Simulator::install() {
+    InstallMCP2210Transport(loopback);
+    installed = true;
+}
+
+void MCP2210Simulator::uninstall() {
+    if (!installed) return;
+    SetMCP2210DefaultTransport(NULL, NULL);
+    installed = false;
+}
+
+LoopbackTransport& MCP2210Simulator::transport() {
+    return loopback;
+}
+
+void MCP2210Simulator::setReportLatency(std::chrono::microseconds reportLatency) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    latency = reportLatency;
+}
+
+void MCP2210Simulator::pulseInterrupt(unsigned int count) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    interruptEvents += count;
+}
+
+unsigned long MCP2210Simulator::reports() const {
+    return reportCount.load(std::memory_order_relaxed);
+}
+
+std::vector<uint16_t> MCP2210Simulator::wipers() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return rdac;
+}
+
+int MCP2210Simulator::handleReport(void* context, byte* cmdBuf, byte* responseBuf) {
+    return static_cast<MCP2210Simulator*>(context)->handle(cmdBuf, responseBuf);
+}
+
+// Attente active : les latences simulées sont souvent inférieures à la résolution de sleep_for
+void MCP2210Simulator::wait(double micros) const {
+    if (micros <= 0.0) return;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double, std::micro>(micros);
+    while (std::chrono::steady_clock::now() < deadline) {
+    }
+}
+
+// Trames de chaîne exécutées l'une après l'autre ; la réponse d'une lecture sort pendant la trame suivante.
+// La chaîne principale (CS sur GP0) garde sa longueur ; une chaîne sur un autre CS (ChainSet, mesures)
+// a la longueur du transfert qui la sélectionne, une trame d'écriture par transfert.
+void MCP2210Simulator::shiftChain(const uint8_t* data, size_t length, uint8_t* response) {
+    unsigned int selected = spiSettings.IdleChipSelectValue & ~spiSettings.ActiveChipSelectValue & GPIO_PIN_MASK;
+    std::vector<uint16_t>* values = &rdac;
+    std::vector<uint16_t>* stored = &memory;
+    if (selected != 0 && (selected & 0x1) == 0) {
+        SimulatedChain& chain = otherChains[selected];
+        chain.rdac.resize(length / 2, 0x200);
+        chain.memory.resize(length / 2, 0x200);
+        values = &chain.rdac;
+        stored = &chain.memory;
+    }
+    size_t frameLength = values->size() * 2;
+    std::memset(response, 0, length);
+    if (frameLength == 0) return;
+
+    for (size_t frame = 0; frame + frameLength <= length; frame += frameLength) {
+        for (size_t i = 0; i < values->size(); ++i) {
+            const uint8_t* word = data + frame + i * 2;
+            uint8_t* next = frame + frameLength * 2 <= length ? response + frame + frameLength + i * 2 : nullptr;
+            uint16_t& wiper = (*values)[i];
+            uint16_t& cell = (*stored)[i];
+            switch (word[0] & 0x3C) {
+            case 0x04:
+                wiper = DefaultPotTraits::decodeValue(word);
+                break;
+            case 0x08:
+                if (next) {
+                    next[0] = (wiper >> 8) & 0x03;
+                    next[1] = wiper & 0xFF;
+                }
+                break;
+            case 0x0C:
+                cell = wiper;
+                break;
+            case 0x14:
+                if (next) {
+                    next[0] = (cell >> 8) & 0x03;
+                    next[1] = cell & 0xFF;
+                }
+                break;
+            default:
+                break; // NOP, registre de contrôle
+            }
+        }
+    }
+}
+
+int MCP2210Simulator::handle(const byte* cmd, byte* rsp) {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    ++reportCount;
+    double spiMicros = 0.0;
+
+    std::memset(rsp, 0, RESPONSE_BUFFER_LENGTH);
+    rsp[0] = cmd[0];
+
+    switch (cmd[0]) {
+    case CMD_SPI_TRANSFER:
+        if (!transferPending) {
+            // Premier rapport : données acceptées, transfert démarré
+            size_t length = cmd[1] > sizeof(SPIDataTransferStatusDef::DataReceived)
+                          ? sizeof(SPIDataTransferStatusDef::DataReceived) : cmd[1];
+            pendingResponse.assign(length, 0);
+            shiftChain(cmd + 4, length, pendingResponse.data());
+            pendingSpiMicros = spiSettings.BitRate > 0 ? length * 8.0 * 1e6 / spiSettings.BitRate : 0.0;
+            transferPending = true;
+            rsp[3] = SPI_STATUS_STARTED_NO_DATA_TO_RECEIVE;
+        } else {
+            // Rapport suivant : fin du transfert et données reçues
+            spiMicros = pendingSpiMicros;
+            rsp[2] = static_cast<byte>(pendingResponse.size());
+            std::memcpy(rsp + 4, pendingResponse.data(), pendingResponse.size());
+            rsp[3] = SPI_STATUS_FINISHED_NO_DATA_TO_SEND;
+            transferPending = false;
+        }
+        break;
+    case CMD_SPI_CANCEL:
+        transferPending = false;
+        [[fallthrough]]; // Même réponse que l'état du circuit
+    case CMD_GET_CHIP_STATUS:
+        rsp[2] = SPI_BUS_RELEASE_EXT_REQ_PENDING;
+        rsp[3] = transferPending ? SPI_BUS_OWNER_USB_BRIDGE : SPI_BUS_OWNER_NONE;
+        break;
+    case CMD_GET_NUM_EVENTS_FROM_INT_PIN:
+        rsp[4] = interruptEvents & 0xFF;
+        rsp[5] = (interruptEvents >> 8) & 0xFF;
+        if (cmd[1] == 0x0) interruptEvents = 0;
+        break;
+    case CMD_GET_SPI_SETTING:
+    case CMD_SET_SPI_SETTING:
+        if (cmd[0] == CMD_SET_SPI_SETTING) {
+            spiSettings.BitRate = cmd[7] << 24 | cmd[6] << 16 | cmd[5] << 8 | cmd[4];
+            spiSettings.IdleChipSelectValue = (cmd[9] & 0x1) << 8 | cmd[8];
+            spiSettings.ActiveChipSelectValue = (cmd[11] & 0x1) << 8 | cmd[10];
+            spiSettings.CSToDataDelay = cmd[13] << 8 | cmd[12];
+            spiSettings.LastDataByteToCSDelay = cmd[15] << 8 | cmd[14];
+            spiSettings.SubsequentDataByteDelay = cmd[17] << 8 | cmd[16];
+            spiSettings.BytesPerSPITransfer = cmd[19] << 8 | cmd[18];
+            spiSettings.SPIMode = cmd[20];
+        }
+        rsp[4] = spiSettings.BitRate & 0xFF;
+        rsp[5] = (spiSettings.BitRate >> 8) & 0xFF;
+        rsp[6] = (spiSettings.BitRate >> 16) & 0xFF;
+        rsp[7] = (spiSettings.BitRate >> 24) & 0xFF;
+        rsp[8] = spiSettings.IdleChipSelectValue & 0xFF;
+        rsp[9] = (spiSettings.IdleChipSelectValue >> 8) & 0x1;
+        rsp[10] = spiSettings.ActiveChipSelectValue & 0xFF;
+        rsp[11] = (spiSettings.ActiveChipSelectValue >> 8) & 0x1;
+        rsp[12] = spiSettings.CSToDataDelay & 0xFF;
+        rsp[13] = (spiSettings.CSToDataDelay >> 8) & 0xFF;
+        rsp[14] = spiSettings.LastDataByteToCSDelay & 0xFF;
+        rsp[15] = (spiSettings.LastDataByteToCSDelay >> 8) & 0xFF;
+        rsp[16] = spiSettings.SubsequentDataByteDelay & 0xFF;
+        rsp[17] = (spiSettings.SubsequentDataByteDelay >> 8) & 0xFF;
+        rsp[18] = spiSettings.BytesPerSPITransfer & 0xFF;
+        rsp[19] = (spiSettings.BytesPerSPITransfer >> 8) & 0xFF;
+        rsp[20] = spiSettings.SPIMode;
+        break;
+    case CMD_GET_GPIO_SETTING:
+    case CMD_SET_GPIO_SETTING:
+        if (cmd[0] == CMD_SET_GPIO_SETTING) {
+            std::memcpy(designations, cmd + 4, sizeof(designations));
+        }
+        std::memcpy(rsp + 4, designations, sizeof(designations));
+        rsp[13] = gpioValues & 0xFF;
+        rsp[14] = (gpioValues >> 8) & 0x1;
+        rsp[15] = gpioDirections & 0xFF;
+        rsp[16] = (gpioDirections >> 8) & 0x1;
+        break;
+    case CMD_SET_GPIO_PIN_VAL:
+        gpioValues = (cmd[5] & 0x1) << 8 | cmd[4];
+        [[fallthrough]]; // Réponse identique à la lecture
+    case CMD_GET_GPIO_PIN_VAL:
+        rsp[4] = gpioValues & 0xFF;
+        rsp[5] = (gpioValues >> 8) & 0x1;
+        break;
+    case CMD_SET_GPIO_PIN_DIR:
+        gpioDirections = (cmd[5] & 0x1) << 8 | cmd[4];
+        [[fallthrough]]; // Réponse identique à la lecture
+    case CMD_GET_GPIO_PIN_DIR:
+        rsp[4] = gpioDirections & 0xFF;
+        rsp[5] = (gpioDirections >> 8) & 0x1;
+        break;
+    case CMD_READ_EEPROM_MEM:
+        rsp[3] = eeprom[cmd[1]];
+        break;
+    case CMD_WRITE_EEPROM_MEM:
+        eeprom[cmd[1]] = cmd[2];
+        break;
+    default:
+        break; // Commandes sans effet sur le simulateur : succès
+    }
+
+    double micros = latency.count() + spiMicros;
+    lock.unlock();
+    wait(micros);
+    return OPERATION_SUCCESSFUL;
+}
@@ -0,0 +1,231 @@
+#include "MCP2210Transport.h"
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#endif
+
+#ifdef __linux__
+HidrawTransport::HidrawTransport(const std::string& path) : deviceFd(open(path.c_str(), O_RDWR | O_CLOEXEC)) {
+    if (deviceFd < 0) {
+        throw std::runtime_error("Erreur : ouverture de " + path + " impossible (" + std::strerror(errno) + ").");
+    }
+}
+
+HidrawTransport::HidrawTransport(int fd) : deviceFd(fd) {
+    if (deviceFd < 0) {
+        throw std::runtime_error("Erreur : descripteur hidraw invalide.");
+    }
+}
+
+HidrawTransport::~HidrawTransport() {
+    close(deviceFd);
+}
+
+int HidrawTransport::submit(const byte* report) {
+    return write(deviceFd, report, COMMAND_BUFFER_LENGTH) < 0 ? ERROR_UNABLE_TO_WRITE_TO_DEVICE : 0;
+}
+
+int HidrawTransport::receive(byte* report, int timeoutMs) {
+    int ready = wait(timeoutMs);
+    if (ready <= 0) return ready;
+    ssize_t n = read(deviceFd, report, RESPONSE_BUFFER_LENGTH);
+    if (n < 0) return errno == EAGAIN ? 0 : ERROR_UNABLE_TO_READ_FROM_DEVICE;
+    return static_cast<int>(n);
+}
+
+int HidrawTransport::wait(int timeoutMs) {
+    struct pollfd pfd;
+    pfd.fd = deviceFd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int r;
+    do {
+        r = poll(&pfd, 1, timeoutMs);
+    } while (r < 0 && errno == EINTR);
+    if (r < 0 || (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))) return ERROR_UNABLE_TO_READ_FROM_DEVICE;
+    return r;
+}
+
+int HidrawTransport::fd() const {
+    return deviceFd;
+}
+#endif
+
+LoopbackTransport::LoopbackTransport(MCP2210VirtualHandler handler, void* context)
+    : handler(handler), context(context), head(0), count(0), eventFd(-1) {}
+
+LoopbackTransport::~LoopbackTransport() {
+#ifdef __linux__
+    if (eventFd >= 0) close(eventFd);
+#endif
+}
+
+void LoopbackTransport::setResponder(MCP2210VirtualHandler newHandler, void* newContext) {
+    handler = newHandler;
+    context = newContext;
+    head = 0;
+    count = 0;
+}
+
+int LoopbackTransport::submit(const byte* report) {
+    if (!handler) return ERROR_INVALID_DEVICE_HANDLE;
+    if (count == MCP2210_LOOPBACK_DEPTH) return ERROR_UNABLE_TO_WRITE_TO_DEVICE;
+
+    byte* response = responses[(head + count) % MCP2210_LOOPBACK_DEPTH];
+    std::memset(response, 0, RESPONSE_BUFFER_LENGTH);
+    int r = handler(context, const_cast<byte*>(report), response);
+    if (r < 0) return r;
+    // Le code rendu par le gestionnaire fait foi pour l'octet d'état
+    response[1] = static_cast<byte>(r);
+    ++count;
+
+#ifdef __linux__
+    if (eventFd >= 0) {
+        uint64_t one = 1;
+        if (write(eventFd, &one, sizeof(one)) < 0) return ERROR_UNABLE_TO_WRITE_TO_DEVICE;
+    }
+#endif
+    return 0;
+}
+
+int LoopbackTransport::receive(byte* report, int) {
+    // Réponses produites à la soumission : rien à attendre
+    if (count == 0) return ERROR_UNABLE_TO_READ_FROM_DEVICE;
+    std::memcpy(report, responses[head], RESPONSE_BUFFER_LENGTH);
+    head = (head + 1) % MCP2210_LOOPBACK_DEPTH;
+    --count;
+
+#ifdef __linux__
+    if (eventFd >= 0 && count == 0) {
+        uint64_t pending;
+        if (read(eventFd, &pending, sizeof(pending)) < 0 && errno != EAGAIN) return ERROR_UNABLE_TO_READ_FROM_DEVICE;
+    }
+#endif
+    return RESPONSE_BUFFER_LENGTH;
+}
+
+int LoopbackTransport::wait(int) {
+    return count > 0 ? 1 : ERROR_UNABLE_TO_READ_FROM_DEVICE;
+}
+
+int LoopbackTransport::fd() const {
+#ifdef __linux__
+    if (eventFd < 0) {
+        // Créé à la demande : le chemin sans boucle d'événements reste sans appel système
+        eventFd = eventfd(count, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    return eventFd;
+#else
+    return -1;
+#endif
+}
+
+void WriteRecordedReport(std::ostream& out, char direction, const byte* report) {
+    static const char HEX[] = "0123456789abcdef";
+    char line[2 + 2 * COMMAND_BUFFER_LENGTH + 1];
+    line[0] = direction;
+    line[1] = ' ';
+    for (int i = 0; i < COMMAND_BUFFER_LENGTH; ++i) {
+        line[2 + 2 * i] = HEX[report[i] >> 4];
+        line[3 + 2 * i] = HEX[report[i] & 0x0F];
+    }
+    line[sizeof(line) - 1] = '\n';
+    out.write(line, sizeof(line));
+}
+
+void WriteRecordedStatus(std::ostream& out, int status) {
+    out << "! " << status << '\n';
+}
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+ReplayTransport::ReplayTransport(const std::string& path) : next(0) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Erreur : enregistrement " + path + " introuvable.");
+    }
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#') continue;
+
+        Record record;
+        std::memset(&record, 0, sizeof(record));
+        record.direction = line[0];
+        bool valid = line.size() > 2 && line[1] == ' ';
+        if (valid && record.direction == '!') {
+            char* end = NULL;
+            record.status = static_cast<int>(std::strtol(line.c_str() + 2, &end, 10));
+            valid = end && *end == '\0' && record.status < 0;
+        } else if (valid && (record.direction == '>' || record.direction == '<')) {
+            valid = line.size() == 2 + 2 * COMMAND_BUFFER_LENGTH;
+            for (int i = 0; valid && i < COMMAND_BUFFER_LENGTH; ++i) {
+                int high = hexDigit(line[2 + 2 * i]);
+                int low = hexDigit(line[3 + 2 * i]);
+                valid = high >= 0 && low >= 0;
+                record.report[i] = static_cast<byte>(high << 4 | low);
+            }
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            throw std::runtime_error("Erreur : ligne " + std::to_string(lineNumber) + " invalide dans " + path + ".");
+        }
+        records.push_back(record);
+    }
+}
+
+int ReplayTransport::takeStatus() {
+    if (next < records.size() && records[next].direction == '!') {
+        return records[next++].status;
+    }
+    return 0;
+}
+
+int ReplayTransport::submit(const byte* report) {
+    if (next >= records.size() || records[next].direction != '>'
+        || std::memcmp(records[next].report, report, COMMAND_BUFFER_LENGTH) != 0) {
+        return ERROR_TRANSPORT_REPLAY_MISMATCH;
+    }
+    ++next;
+    return takeStatus();
+}
+
+int ReplayTransport::receive(byte* report, int) {
+    int status = takeStatus();
+    if (status < 0) return status;
+    if (next >= records.size() || records[next].direction != '<') {
+        return ERROR_UNABLE_TO_READ_FROM_DEVICE;
+    }
+    std::memcpy(report, records[next++].report, RESPONSE_BUFFER_LENGTH);
+    return RESPONSE_BUFFER_LENGTH;
+}
+
+int ReplayTransport::wait(int) {
+    return next < records.size() ? 1 : ERROR_UNABLE_TO_READ_FROM_DEVICE;
+}
+
+int ReplayTransport::fd() const {
+    return -1;
+}
+
+size_t ReplayTransport::position() const {
+    return next;
+}
+
+bool ReplayTransport::finished() const {
+    return next >= records.size();
+}
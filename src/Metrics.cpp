@@ -0,0 +1,425 @@
+#include "Metrics.h"
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+// Bornes supérieures des classes, en microsecondes (la dernière classe est +Inf)
+static const double LATENCY_BOUNDS[METRICS_LATENCY_BUCKETS - 1] = {
+    50, 100, 250, 500, 1000, 2000, 5000, 10000, 25000, 100000
+};
+
+static const std::memory_order RELAXED = std::memory_order_relaxed;
+
+static void clearCounters(std::atomic<uint64_t>* counters, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        counters[i].store(0, RELAXED);
+    }
+}
+
+static std::string hexLabel(unsigned int value) {
+    char text[8];
+    std::snprintf(text, sizeof(text), "0x%02x", value);
+    return text;
+}
+
+LatencyHistogram::LatencyHistogram() : total(0), sumNanos(0) {
+    clearCounters(buckets, METRICS_LATENCY_BUCKETS);
+}
+
+void LatencyHistogram::observe(double micros) {
+    size_t bucket = 0;
+    while (bucket < METRICS_LATENCY_BUCKETS - 1 && micros > LATENCY_BOUNDS[bucket]) {
+        ++bucket;
+    }
+    buckets[bucket].fetch_add(1, RELAXED);
+    total.fetch_add(1, RELAXED);
+    sumNanos.fetch_add(static_cast<uint64_t>(micros * 1000.0), RELAXED);
+}
+
+uint64_t LatencyHistogram::count() const {
+    return total.load(RELAXED);
+}
+
+void LatencyHistogram::write(std::ostream& out, const char* name, const std::string& labels) const {
+    std::string prefix = labels.empty() ? "{" : "{" + labels + ",";
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < METRICS_LATENCY_BUCKETS; ++i) {
+        cumulative += buckets[i].load(RELAXED);
+        out << name << "_bucket" << prefix << "le=\"";
+        if (i < METRICS_LATENCY_BUCKETS - 1) {
+            out << LATENCY_BOUNDS[i];
+        } else {
+            out << "+Inf";
+        }
+        out << "\"} " << cumulative << "\n";
+    }
+    std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+    out << name << "_sum" << suffix << " " << sumNanos.load(RELAXED) / 1000.0 << "\n";
+    out << name << "_count" << suffix << " " << cumulative << "\n";
+}
+
+Metrics& Metrics::global() {
+    static Metrics instance;
+    return instance;
+}
+
+Metrics::Metrics() : spiCancellations(0), spiBytes(0), reconnects(0), cacheHits(0), cacheMisses(0), cacheStale(0) {
+    clearCounters(libraryErrors, METRICS_LIBRARY_ERRORS);
+    clearCounters(deviceErrors, 256);
+    clearCounters(engineStatuses, 256);
+    clearCounters(potWrites, NUM_POTS);
+    clearCounters(potStores, NUM_POTS);
+}
+
+static void commandObserver(void* context, const byte* cmdBuf, const byte* responseBuf, int result, double micros) {
+    // L'état du moteur SPI n'a de sens que pour un rapport de transfert accepté
+    uint8_t engineStatus = (cmdBuf[0] == CMD_SPI_TRANSFER && result == 0) ? responseBuf[3] : 0;
+    static_cast<Metrics*>(context)->recordCommand(cmdBuf[0], result, engineStatus, micros);
+}
+
+void Metrics::observeCommands() {
+    SetMCP2210CommandObserver(&commandObserver, this);
+}
+
+void Metrics::stopObservingCommands() {
+    SetMCP2210CommandObserver(NULL, NULL);
+}
+
+void Metrics::recordCommand(uint8_t opcode, int result, uint8_t engineStatus, double micros) {
+    commandLatency[opcode].observe(micros);
+    if (result < 0) {
+        int code = -result < METRICS_LIBRARY_ERRORS ? -result : METRICS_LIBRARY_ERRORS - 1;
+        libraryErrors[code].fetch_add(1, RELAXED);
+    } else if (result > 0) {
+        deviceErrors[result & 0xFF].fetch_add(1, RELAXED);
+    } else if (engineStatus != 0) {
+        engineStatuses[engineStatus].fetch_add(1, RELAXED);
+    }
+}
+
+void Metrics::recordSpiTransfer(size_t bytes, double micros) {
+    spiTransferLatency.observe(micros);
+    spiBytes.fetch_add(bytes, RELAXED);
+}
+
+void Metrics::recordSpiOutcome(const SPITransferOutcomeDef& outcome) {
+    if (outcome.Outcome >= 0 && outcome.Outcome <= SPI_TRANSFER_BUS_UNAVAILABLE) {
+        spiOutcomeLatency[outcome.Outcome].observe(outcome.ElapsedMicros);
+    }
+    if (outcome.Cancelled) {
+        spiCancellations.fetch_add(1, RELAXED);
+    }
+}
+
+void Metrics::recordReconnect() {
+    reconnects.fetch_add(1, RELAXED);
+}
+
+void Metrics::recordCacheHit() {
+    cacheHits.fetch_add(1, RELAXED);
+}
+
+void Metrics::recordCacheMiss() {
+    cacheMisses.fetch_add(1, RELAXED);
+}
+
+void Metrics::recordCacheStale() {
+    cacheStale.fetch_add(1, RELAXED);
+}
+
+void Metrics::recordPotWrite(int pot) {
+    if (pot >= 0 && pot < NUM_POTS) potWrites[pot].fetch_add(1, RELAXED);
+}
+
+void Metrics::recordPotStore(int pot) {
+    if (pot >= 0 && pot < NUM_POTS) potStores[pot].fetch_add(1, RELAXED);
+}
+
+static void writeHeader(std::ostream& out, const char* name, const char* type, const char* help) {
+    out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+}
+
+static void writeCounter(std::ostream& out, const char* name, const std::string& labels, uint64_t value) {
+    out << name;
+    if (!labels.empty()) out << "{" << labels << "}";
+    out << " " << value << "\n";
+}
+
+void Metrics::writePrometheus(std::ostream& out) const {
+    writeHeader(out, "mcp2210_usb_command_duration_microseconds", "histogram",
+                "Aller-retour des commandes USB par code d'opération.");
+    for (int opcode = 0; opcode < METRICS_OPCODES; ++opcode) {
+        if (commandLatency[opcode].count() == 0) continue;
+        commandLatency[opcode].write(out, "mcp2210_usb_command_duration_microseconds",
+                                     "opcode=\"" + hexLabel(opcode) + "\"");
+    }
+
+    writeHeader(out, "mcp2210_command_errors_total", "counter",
+                "Commandes en échec : code négatif de la bibliothèque ou octet d'état du MCP2210.");
+    for (int code = 1; code < METRICS_LIBRARY_ERRORS; ++code) {
+        uint64_t value = libraryErrors[code].load(RELAXED);
+        if (value) writeCounter(out, "mcp2210_command_errors_total", "code=\"-" + std::to_string(code) + "\"", value);
+    }
+    for (int status = 1; status < 256; ++status) {
+        uint64_t value = deviceErrors[status].load(RELAXED);
+        if (value) writeCounter(out, "mcp2210_command_errors_total", "code=\"" + hexLabel(status) + "\"", value);
+    }
+
+    writeHeader(out, "mcp2210_spi_engine_reports_total", "counter",
+                "Réponses aux rapports de transfert SPI par état du moteur (0x20, 0x30 : sondages, 0x10 : terminé).");
+    for (int status = 1; status < 256; ++status) {
+        uint64_t value = engineStatuses[status].load(RELAXED);
+        if (value) writeCounter(out, "mcp2210_spi_engine_reports_total", "engine_status=\"" + hexLabel(status) + "\"", value);
+    }
+
+    writeHeader(out, "mcp2210_spi_transfer_duration_microseconds", "histogram",
+                "Durée des transferts SPI complets de la chaîne.");
+    spiTransferLatency.write(out, "mcp2210_spi_transfer_duration_microseconds", "");
+
+    static const char* OUTCOME_LABELS[] = {"completed", "failed", "timeout", "bus_unavailable"};
+    writeHeader(out, "mcp2210_spi_transfer_outcome_duration_microseconds", "histogram",
+                "Durée des transferts SPI par issue, sondages et annulation compris.");
+    for (int outcome = 0; outcome <= SPI_TRANSFER_BUS_UNAVAILABLE; ++outcome) {
+        if (spiOutcomeLatency[outcome].count() == 0) continue;
+        spiOutcomeLatency[outcome].write(out, "mcp2210_spi_transfer_outcome_duration_microseconds",
+                                         std::string("outcome=\"") + OUTCOME_LABELS[outcome] + "\"");
+    }
+    writeHeader(out, "mcp2210_spi_cancellations_total", "counter", "Transferts SPI expirés annulés par CancelSPITransfer.");
+    writeCounter(out, "mcp2210_spi_cancellations_total", "", spiCancellations.load(RELAXED));
+    writeHeader(out, "mcp2210_spi_transfer_bytes_total", "counter", "Octets SPI échangés.");
+    writeCounter(out, "mcp2210_spi_transfer_bytes_total", "", spiBytes.load(RELAXED));
+
+    writeHeader(out, "mcp2210_reconnects_total", "counter", "Réouvertures de l'adaptateur.");
+    writeCounter(out, "mcp2210_reconnects_total", "", reconnects.load(RELAXED));
+
+    writeHeader(out, "mcp2210_cache_lookups_total", "counter", "Lectures RDAC servies par le cache ou non.");
+    writeCounter(out, "mcp2210_cache_lookups_total", "result=\"hit\"", cacheHits.load(RELAXED));
+    writeCounter(out, "mcp2210_cache_lookups_total", "result=\"miss\"", cacheMisses.load(RELAXED));
+    writeHeader(out, "mcp2210_cache_stale_refreshes_total", "counter",
+                "Relectures matérielles différentes du cache.");
+    writeCounter(out, "mcp2210_cache_stale_refreshes_total", "", cacheStale.load(RELAXED));
+
+    writeHeader(out, "mcp2210_pot_writes_total", "counter", "Écritures RDAC par potentiomètre de la chaîne principale.");
+    for (int i = 0; i < NUM_POTS; ++i) {
+        writeCounter(out, "mcp2210_pot_writes_total", "pot=\"" + std::to_string(i + 1) + "\"", potWrites[i].load(RELAXED));
+    }
+    writeHeader(out, "mcp2210_pot_stores_total", "counter", "Stockages 50-TP par potentiomètre de la chaîne principale.");
+    for (int i = 0; i < NUM_POTS; ++i) {
+        writeCounter(out, "mcp2210_pot_stores_total", "pot=\"" + std::to_string(i + 1) + "\"", potStores[i].load(RELAXED));
+    }
+}
+
+MetricsExporter::MetricsExporter(const Metrics& metrics, const std::string& listen, const std::string& textfile,
+                                 std::chrono::seconds period)
+    : metrics(metrics), textfilePath(textfile), period(period), listenFd(-1), wakeFds{-1, -1}, running(true) {
+    if (!listen.empty()) {
+        listenOn(listen);
+    }
+    writeTextfile();
+    worker = std::thread(&MetricsExporter::run, this);
+}
+
+MetricsExporter::~MetricsExporter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wakeUp.notify_all();
+#ifndef _WIN32
+    if (wakeFds[1] >= 0) {
+        char stop = 0;
+        if (write(wakeFds[1], &stop, 1) < 0) {}
+    }
+#endif
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+    // Dernière photographie : les compteurs d'une commande ponctuelle restent lisibles
+    try {
+        writeTextfile();
+    } catch (const std::exception&) {}
+
+#ifndef _WIN32
+    if (listenFd >= 0) close(listenFd);
+    if (wakeFds[0] >= 0) close(wakeFds[0]);
+    if (wakeFds[1] >= 0) close(wakeFds[1]);
+    if (!unixPath.empty()) unlink(unixPath.c_str());
+#endif
+}
+
+std::string MetricsExporter::endpoint() const {
+    return boundEndpoint;
+}
+
+// Écriture dans un fichier temporaire puis renommage : node_exporter ne lit jamais un fichier partiel
+void MetricsExporter::writeTextfile() const {
+    if (textfilePath.empty()) return;
+
+    std::string temporary = textfilePath + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Erreur : impossible d'écrire le fichier de métriques.");
+        }
+        metrics.writePrometheus(out);
+        if (!out) {
+            throw std::runtime_error("Erreur : écriture du fichier de métriques incomplète.");
+        }
+    }
+#ifdef _WIN32
+    std::remove(textfilePath.c_str());
+#endif
+    if (std::rename(temporary.c_str(), textfilePath.c_str()) != 0) {
+        throw std::runtime_error("Erreur : impossible de remplacer le fichier de métriques.");
+    }
+}
+
+#ifndef _WIN32
+void MetricsExporter::listenOn(const std::string& listen) {
+    if (listen.compare(0, 5, "unix:") == 0) {
+        unixPath = listen.substr(5);
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        if (unixPath.empty() || unixPath.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("Erreur : chemin de socket Unix invalide.");
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, unixPath.c_str(), unixPath.size());
+        unlink(unixPath.c_str());
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            unixPath.clear();
+            throw std::runtime_error("Erreur : impossible d'ouvrir la socket de métriques " + listen + ".");
+        }
+        boundEndpoint = listen;
+    } else {
+        // Seulement sur l'interface locale : les compteurs ne sont pas exposés au réseau
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(static_cast<uint16_t>(std::stoi(listen)));
+
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        if (listenFd >= 0) setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        socklen_t length = sizeof(address);
+        if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+            || getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            if (listenFd >= 0) close(listenFd);
+            listenFd = -1;
+            throw std::runtime_error("Erreur : impossible d'écouter sur le port de métriques " + listen + ".");
+        }
+        boundEndpoint = "http://127.0.0.1:" + std::to_string(ntohs(address.sin_port)) + "/metrics";
+    }
+
+    if (::listen(listenFd, 8) != 0 || pipe(wakeFds) != 0) {
+        close(listenFd);
+        listenFd = -1;
+        throw std::runtime_error("Erreur : impossible d'écouter sur " + listen + ".");
+    }
+}
+
+void MetricsExporter::serveClient(int fd) const {
+    // Délai court : un client lent ne bloque pas la réécriture du fichier
+    timeval timeout = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char request[1024];
+    ssize_t received = recv(fd, request, sizeof(request) - 1, 0);
+    if (received <= 0) return;
+    request[received] = '\0';
+
+    std::ostringstream body;
+    const char* status = "200 OK";
+    if (std::strncmp(request, "GET ", 4) == 0) {
+        metrics.writePrometheus(body);
+    } else {
+        status = "405 Method Not Allowed";
+    }
+
+    std::string payload = body.str();
+    std::ostringstream response;
+    response << "HTTP/1.0 " << status << "\r\n"
+             << "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+             << "Content-Length: " << payload.size() << "\r\n"
+             << "Connection: close\r\n\r\n" << payload;
+
+    std::string text = response.str();
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags = MSG_NOSIGNAL;
+#endif
+    for (size_t sent = 0; sent < text.size();) {
+        ssize_t n = send(fd, text.data() + sent, text.size() - sent, flags);
+        if (n <= 0) break;
+        sent += static_cast<size_t>(n);
+    }
+}
+
+void MetricsExporter::run() {
+    auto nextWrite = std::chrono::steady_clock::now() + period;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running) return;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= nextWrite) {
+            try {
+                writeTextfile();
+            } catch (const std::exception&) {}
+            nextWrite = now + period;
+            continue;
+        }
+
+        if (listenFd < 0) {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait_until(lock, nextWrite, [this] { return !running; });
+            continue;
+        }
+
+        pollfd fds[2] = {{listenFd, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+        int waitMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(nextWrite - now).count()) + 1;
+        if (poll(fds, 2, waitMs) > 0 && (fds[0].revents & POLLIN)) {
+            int client = accept(listenFd, nullptr, nullptr);
+            if (client >= 0) {
+                serveClient(client);
+                close(client);
+            }
+        }
+    }
+}
+#else
+void MetricsExporter::listenOn(const std::string&) {
+    throw std::runtime_error("Erreur : point d'accès de métriques non disponible sous Windows (utiliser le fichier).");
+}
+
+void MetricsExporter::serveClient(int) const {}
+
+void MetricsExporter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        if (!wakeUp.wait_for(lock, period, [this] { return !running; })) {
+            try {
+                writeTextfile();
+            } catch (const std::exception&) {}
+        }
+    }
+}
+#endif
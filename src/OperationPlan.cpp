@@ -0,0 +1,175 @@
+#include "OperationPlan.h"
+#include <stdexcept>
+#include <cstring>
+
+// Étape élémentaire d'un potentiomètre : deux octets de commande
+struct PotStep {
+    uint8_t high;
+    uint8_t low;
+    char kind; // 'E' contrôle, 'W' écriture, 'R' lecture, 'S' stockage
+};
+
+static const size_t MAX_FRAMES_PER_TRANSFER = SPI_REPORT_PAYLOAD / CHAIN_FRAME_LENGTH;
+
+static std::string describeFrame(const std::vector<PotStep>& steps) {
+    size_t counts[4] = {0, 0, 0, 0};
+    const char kinds[4] = {'E', 'W', 'R', 'S'};
+    const char* names[4] = {"contrôle 0x1C03", "écriture", "lecture", "stockage"};
+    for (const PotStep& step : steps) {
+        for (int k = 0; k < 4; ++k) {
+            if (step.kind == kinds[k]) ++counts[k];
+        }
+    }
+
+    std::string description;
+    for (int k = 0; k < 4; ++k) {
+        if (counts[k] == 0) continue;
+        if (!description.empty()) description += ", ";
+        description += names[k] + std::string(" x") + std::to_string(counts[k]);
+    }
+    return description.empty() ? "NOP" : description;
+}
+
+OperationPlan OperationPlan::compile(const std::vector<PotPlan>& pots) {
+    if (pots.size() != NUM_POTS) {
+        throw std::runtime_error("Erreur : le nombre de valeurs ne correspond pas au nombre de potentiomètres.");
+    }
+
+    OperationPlan plan;
+    plan.potPlans = pots;
+    plan.naiveTransactions = 0;
+
+    // Séquence d'étapes propre à chaque potentiomètre, dans l'ordre contrôle, écriture, lecture ;
+    // les stockages partagent une dernière trame, seule dans son transfert : aucune commande ne
+    // suit un stockage pendant le cycle d'écriture 50-TP
+    std::vector<PotStep> sequences[NUM_POTS];
+    std::vector<PotStep> storeSteps;
+    std::vector<uint8_t> storeFrame(CHAIN_FRAME_LENGTH, 0x00);
+    std::bitset<NUM_POTS> storedPots;
+    size_t frameCount = 0;
+    for (int i = 0; i < NUM_POTS; ++i) {
+        const PotPlan& pot = pots[i];
+        if (pot.write && pot.value > RDAC_VALUE_MASK) {
+            throw std::runtime_error("Erreur : valeur RDAC hors limites.");
+        }
+        uint8_t frame[DefaultPotTraits::frameBytes];
+        if (pot.enableWrite) {
+            DefaultPotTraits::encodeEnableWrite(frame);
+            sequences[i].push_back({frame[0], frame[1], 'E'});
+        }
+        if (pot.write) {
+            DefaultPotTraits::encodeWrite(pot.value, frame);
+            sequences[i].push_back({frame[0], frame[1], 'W'});
+        }
+        if (pot.verify) {
+            DefaultPotTraits::encodeRead(frame);
+            sequences[i].push_back({frame[0], frame[1], 'R'});
+        }
+        if (pot.store) {
+            DefaultPotTraits::encodeStore(frame);
+            storeSteps.push_back({frame[0], frame[1], 'S'});
+            storeFrame[i * 2] = frame[0];
+            storeFrame[i * 2 + 1] = frame[1];
+            storedPots.set(i);
+            ++plan.naiveTransactions;
+        }
+
+        plan.naiveTransactions += sequences[i].size();
+        if (sequences[i].size() > frameCount) frameCount = sequences[i].size();
+    }
+
+    // Trame k : étape k de chaque potentiomètre, NOP pour ceux qui ont terminé
+    std::vector<std::vector<uint8_t>> frames(frameCount, std::vector<uint8_t>(CHAIN_FRAME_LENGTH, 0x00));
+    std::vector<std::string> descriptions(frameCount);
+    std::vector<bool> hasRead(frameCount, false);
+    for (size_t k = 0; k < frameCount; ++k) {
+        std::vector<PotStep> frameSteps;
+        for (int i = 0; i < NUM_POTS; ++i) {
+            if (k >= sequences[i].size()) continue;
+            const PotStep& step = sequences[i][k];
+            frames[k][i * 2] = step.high;
+            frames[k][i * 2 + 1] = step.low;
+            frameSteps.push_back(step);
+            if (step.kind == 'R') hasRead[k] = true;
+        }
+        descriptions[k] = describeFrame(frameSteps);
+    }
+
+    // Regroupement des trames consécutives dans une même fenêtre CS, dans la limite d'un rapport.
+    // Une trame de lecture ne termine jamais un transfert : la trame suivante (ou un NOP) récupère la réponse.
+    PlannedTransfer current;
+    auto frameTotal = [](const PlannedTransfer& transfer) { return transfer.frames.size() / CHAIN_FRAME_LENGTH; };
+    auto flush = [&]() {
+        if (current.frames.empty()) return;
+        if (!current.readFrames.empty() && current.readFrames.back() == frameTotal(current) - 1) {
+            current.frames.insert(current.frames.end(), CHAIN_FRAME_LENGTH, 0x00);
+            current.steps.push_back("NOP (réponse)");
+        }
+        plan.plannedTransfers.push_back(current);
+        current = PlannedTransfer();
+    };
+
+    for (size_t k = 0; k < frameCount; ++k) {
+        // Une trame de lecture réserve la place de la trame qui récupère sa réponse
+        size_t needed = hasRead[k] ? 2 : 1;
+        if (frameTotal(current) + needed > MAX_FRAMES_PER_TRANSFER) {
+            flush();
+        }
+        if (hasRead[k]) current.readFrames.push_back(frameTotal(current));
+        current.frames.insert(current.frames.end(), frames[k].begin(), frames[k].end());
+        current.steps.push_back(descriptions[k]);
+    }
+    flush();
+
+    if (storedPots.any()) {
+        current.frames = storeFrame;
+        current.steps.push_back(describeFrame(storeSteps));
+        current.stores = storedPots;
+        flush();
+    }
+
+    return plan;
+}
+
+const std::vector<PlannedTransfer>& OperationPlan::transfers() const {
+    return plannedTransfers;
+}
+
+const std::vector<PotPlan>& OperationPlan::pots() const {
+    return potPlans;
+}
+
+size_t OperationPlan::perPotTransactions() const {
+    return naiveTransactions;
+}
+
+CostEstimate OperationPlan::cost(const TransferCostModel& model) const {
+    std::vector<size_t> sizes;
+    bool stores = false;
+    for (const PlannedTransfer& transfer : plannedTransfers) {
+        sizes.push_back(transfer.frames.size());
+        stores = stores || transfer.stores.any();
+    }
+
+    // Les cycles d'écriture 50-TP des circuits se déroulent en parallèle
+    CostEstimate estimate = model.estimateTransfers(sizes);
+    if (stores) {
+        estimate.totalMicros += model.storeTime();
+    }
+    return estimate;
+}
+
+void OperationPlan::print(std::ostream& out, const TransferCostModel& model) const {
+    for (size_t t = 0; t < plannedTransfers.size(); ++t) {
+        const PlannedTransfer& transfer = plannedTransfers[t];
+        out << "Transfert " << t + 1 << " (" << transfer.frames.size() << " octets)" << std::endl;
+        for (const std::string& step : transfer.steps) {
+            out << "  - " << step << std::endl;
+        }
+    }
+
+    CostEstimate estimate = cost(model);
+    out << estimate.transfers << " transfert(s), " << estimate.reports << " rapport(s) USB, "
+        << estimate.totalMicros / 1000.0 << " ms prévues (" << naiveTransactions
+        << " transactions avec une étape par potentiomètre)" << std::endl;
+}
@@ -0,0 +1,103 @@
+#include "OtpWearLedger.h"
+#include <stdexcept>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Crée chaque composant manquant du chemin (mkdir -p)
+static bool makeDirectories(const std::string& directory) {
+    for (size_t pos = 1; pos <= directory.size(); ++pos) {
+        if (pos < directory.size() && directory[pos] != '/' && directory[pos] != '\\') continue;
+        std::string prefix = directory.substr(0, pos);
+#ifdef _WIN32
+        if (prefix.size() == 2 && prefix[1] == ':') continue; // Lettre de lecteur
+        int r = _mkdir(prefix.c_str());
+#else
+        int r = mkdir(prefix.c_str(), 0700);
+#endif
+        if (r != 0 && errno != EEXIST) return false;
+    }
+    return true;
+}
+
+std::string OtpWearLedger::defaultPath() {
+    std::string directory;
+#ifdef _WIN32
+    if (const char* appData = std::getenv("LOCALAPPDATA")) {
+        directory = std::string(appData) + "\\mcp2210";
+    }
+#else
+    if (const char* state = std::getenv("XDG_STATE_HOME")) {
+        if (state[0] == '/') directory = std::string(state) + "/mcp2210";
+    }
+    if (directory.empty()) {
+        if (const char* home = std::getenv("HOME")) {
+            directory = std::string(home) + "/.local/state/mcp2210";
+        }
+    }
+#endif
+    if (directory.empty()) {
+        return OTP_WEAR_LEDGER_FILE; // Ni HOME ni LOCALAPPDATA (service) : répertoire courant
+    }
+    if (!makeDirectories(directory)) {
+        throw std::runtime_error("Erreur : répertoire du registre d'usure 50-TP introuvable.");
+    }
+#ifdef _WIN32
+    return directory + "\\" + OTP_WEAR_LEDGER_FILE;
+#else
+    return directory + "/" + OTP_WEAR_LEDGER_FILE;
+#endif
+}
+
+// Format texte, une ligne par potentiomètre : <numéro de série> <position> <emplacements utilisés>
+OtpWearLedger::OtpWearLedger(const std::string& path) : path(path) {
+    std::ifstream file(path);
+    std::string serial;
+    int position;
+    unsigned int used;
+    while (file >> serial >> position >> used) {
+        counts[{serial, position}] = used;
+    }
+}
+
+unsigned int OtpWearLedger::slotsUsed(const std::string& serial, int position) const {
+    auto it = counts.find({serial, position});
+    return it != counts.end() ? it->second : 0;
+}
+
+unsigned int OtpWearLedger::slotsLeft(const std::string& serial, int position) const {
+    unsigned int used = slotsUsed(serial, position);
+    return used < OTP_SLOT_COUNT ? OTP_SLOT_COUNT - used : 0;
+}
+
+void OtpWearLedger::recordStore(const std::string& serial, int position) {
+    ++counts[{serial, position}];
+}
+
+void OtpWearLedger::save() const {
+    // Écriture dans un fichier temporaire puis renommage, pour ne jamais perdre le compte
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Erreur : impossible d'écrire le registre d'usure 50-TP.");
+        }
+        for (const auto& entry : counts) {
+            file << entry.first.first << " " << entry.first.second << " " << entry.second << "\n";
+        }
+    }
+#ifdef _WIN32
+    // rename() ne remplace pas un fichier existant sous Windows
+    std::remove(path.c_str());
+#endif
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Erreur : impossible d'écrire le registre d'usure 50-TP.");
+    }
+}
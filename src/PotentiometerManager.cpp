@@ -1,25 +1,575 @@
 #include "PotentiometerManager.h"
+#include "Metrics.h"
 #include <stdexcept>
+#include <thread>
+#include <algorithm>
 
-PotentiometerManager::PotentiometerManager() {}
+PotentiometerManager::PotentiometerManager(const std::string& pathCacheFile)
+    : mcpInterface(pathCacheFile), gpioShadow(mcpInterface), chainSet(mcpInterface), cacheEnabled(false), cacheValid(false), cacheTtl(0), cacheCounters{0, 0, 0} {
+    // Chaque transfert réel affine l'estimation du temps d'aller-retour USB
+    mcpInterface.setTransferObserver([this](size_t bytes, const SPITransferOutcomeDef& outcome) {
+        Metrics::global().recordSpiTransfer(bytes, outcome.ElapsedMicros);
+        std::lock_guard<std::mutex> lock(costModelMutex);
+        transferCostModel.calibrate(outcome);
+    });
+    mcpInterface.setOutcomeObserver([](const SPITransferOutcomeDef& outcome) {
+        Metrics::global().recordSpiOutcome(outcome);
+    });
+}
 
-PotentiometerManager::~PotentiometerManager() {}
+PotentiometerManager::~PotentiometerManager() {
+    mcpInterface.setTransferObserver(nullptr);
+    mcpInterface.setOutcomeObserver(nullptr);
+}
 
 std::vector<uint16_t> PotentiometerManager::readCurrentResistances() {
-    return mcpInterface.readCurrentResistances();
+    return tryReadCurrentResistances().valueOrThrow();
+}
+
+Expected<std::vector<uint16_t>> PotentiometerManager::tryReadCurrentResistances() {
+    if (cacheEnabled && cacheValid
+        && (cacheTtl.count() == 0 || std::chrono::steady_clock::now() - cacheTime < cacheTtl)) {
+        ++cacheCounters.hits;
+        Metrics::global().recordCacheHit();
+        return cachedValues;
+    }
+
+    if (cacheEnabled) {
+        ++cacheCounters.misses;
+        Metrics::global().recordCacheMiss();
+    }
+    return tryRefreshCurrentResistances();
+}
+
+std::vector<uint16_t> PotentiometerManager::refreshCurrentResistances() {
+    return tryRefreshCurrentResistances().valueOrThrow();
+}
+
+Expected<std::vector<uint16_t>> PotentiometerManager::tryRefreshCurrentResistances() {
+    Expected<std::vector<uint16_t>> result = mcpInterface.tryReadCurrentResistances();
+    if (!result) {
+        invalidateCache();
+        return result;
+    }
+    const std::vector<uint16_t>& values = result.value();
+
+    // Valeurs relues différentes du cache : le circuit a été réinitialisé ou modifié ailleurs
+    if (cacheEnabled && cacheValid) {
+        for (int i = 0; i < NUM_POTS; ++i) {
+            if ((values[i] & RDAC_VALUE_MASK) != (cachedValues[i] & RDAC_VALUE_MASK)) {
+                ++cacheCounters.staleRefreshes;
+                Metrics::global().recordCacheStale();
+                break;
+            }
+        }
+    }
+
+    recordChainState(values, false);
+    return result;
+}
+
+void PotentiometerManager::enableCache(std::chrono::milliseconds ttl) {
+    cacheEnabled = true;
+    cacheTtl = ttl;
+}
+
+void PotentiometerManager::disableCache() {
+    cacheEnabled = false;
+    invalidateCache();
+}
+
+void PotentiometerManager::invalidateCache() {
+    cacheValid = false;
+}
+
+void PotentiometerManager::enableArbitration(std::chrono::milliseconds timeout, bool externalMaster) {
+    mcpInterface.enableArbitration(timeout, externalMaster);
+}
+
+const AdapterLock* PotentiometerManager::arbitration() const {
+    return mcpInterface.arbitration();
+}
+
+bool PotentiometerManager::probe() {
+    return mcpInterface.probe();
+}
+
+bool PotentiometerManager::faultDetected() const {
+    return mcpInterface.faultDetected();
+}
+
+void PotentiometerManager::reconnect() {
+    // L'état programmé est rejoué par l'interface : le cache reste valable
+    mcpInterface.reconnect();
+    Metrics::global().recordReconnect();
+}
+
+CostEstimate PotentiometerManager::estimate(ChainOperation operation) {
+    std::lock_guard<std::mutex> lock(costModelMutex);
+    return transferCostModel.estimate(operation);
+}
+
+CostEstimate PotentiometerManager::estimate(const OperationPlan& plan) {
+    std::lock_guard<std::mutex> lock(costModelMutex);
+    return plan.cost(transferCostModel);
+}
+
+TransferCostModel& PotentiometerManager::costModel() {
+    return transferCostModel;
+}
+
+// Mesure directe de l'aller-retour USB avec des lectures d'état, puis chargement des paramètres SPI.
+// Une lecture de la chaîne au préalable relève le nombre de sondages que rend le moteur SPI.
+double PotentiometerManager::measureRoundTrip(unsigned int samples) {
+    SPITransferSettingsDef settings = spiSettings();
+    mcpInterface.tryReadCurrentResistances();
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < samples; ++i) {
+        mcpInterface.chipStatus();
+    }
+    double roundTrip = samples > 0
+        ? std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / samples
+        : transferCostModel.roundTrip();
+
+    std::lock_guard<std::mutex> lock(costModelMutex);
+    transferCostModel.setSettings(settings);
+    transferCostModel.setRoundTrip(roundTrip);
+    return roundTrip;
+}
+
+// Paramètres de la chaîne principale, pas ceux d'une chaîne secondaire restés en place
+SPITransferSettingsDef PotentiometerManager::spiSettings() {
+    MCP2210Interface::Transaction transaction(mcpInterface);
+    chainSet.selectMain();
+    return mcpInterface.readSpiSettings();
+}
+
+void PotentiometerManager::setTransferPolicy(const SPITransferPolicyDef& policy) {
+    mcpInterface.setTransferPolicy(policy);
+    std::lock_guard<std::mutex> lock(costModelMutex);
+    transferCostModel.setPollLimit(policy.MaxPolls);
+}
+
+SPITransferPolicyDef PotentiometerManager::transferPolicy() const {
+    return mcpInterface.transferPolicy();
+}
+
+SPITransferOutcomeDef PotentiometerManager::lastTransferOutcome() const {
+    return mcpInterface.lastTransferOutcome();
+}
+
+OpenTiming PotentiometerManager::openTiming() const {
+    return mcpInterface.openTiming();
+}
+
+void PotentiometerManager::configureSpi(const SPITransferSettingsDef& settings) {
+    {
+        MCP2210Interface::Transaction transaction(mcpInterface);
+        chainSet.selectMain();
+        mcpInterface.writeSpiSettings(settings);
+        chainSet.invalidateSettings();
+    }
+    std::lock_guard<std::mutex> lock(costModelMutex);
+    transferCostModel.setSettings(settings);
+}
+
+std::string PotentiometerManager::serialNumber() {
+    return mcpInterface.serialNumber();
+}
+
+uint8_t PotentiometerManager::readEeprom(uint8_t address) {
+    return mcpInterface.readEeprom(address);
+}
+
+ChipStatusDef PotentiometerManager::chipStatus() {
+    return mcpInterface.chipStatus();
+}
+
+GpioShadow& PotentiometerManager::gpio() {
+    return gpioShadow;
+}
+
+ChainSet& PotentiometerManager::chains() {
+    return chainSet;
+}
+
+CacheStats PotentiometerManager::cacheStats() const {
+    return cacheCounters;
+}
+
+void PotentiometerManager::updateCache(const std::vector<uint16_t>& values) {
+    if (!cacheEnabled) return;
+    cachedValues = values;
+    cacheValid = true;
+    cacheTime = std::chrono::steady_clock::now();
+}
+
+// État connu de la chaîne principale : cache et segment partagé
+void PotentiometerManager::recordChainState(const std::vector<uint16_t>& values, bool written) {
+    updateCache(values);
+    if (written) {
+        for (int i = 0; i < NUM_POTS; ++i) {
+            Metrics::global().recordPotWrite(i);
+        }
+    }
+    if (statePublisher) {
+        statePublisher->publishValues(0, values, written);
+    }
+}
+
+void PotentiometerManager::recordWriteError() {
+    if (statePublisher) {
+        statePublisher->recordWriteError(0);
+    }
+}
+
+// Une valeur invalide n'a rien envoyé : seul un échec du transfert est compté
+void PotentiometerManager::recordWriteError(const ErrorCode& error) {
+    if (error.kind != ErrorKind::InvalidArgument) {
+        recordWriteError();
+    }
+}
+
+void PotentiometerManager::recordVerifyErrors(const std::bitset<NUM_POTS>& mismatches) {
+    if (!statePublisher) return;
+    for (int i = 0; i < NUM_POTS; ++i) {
+        if (mismatches[i]) {
+            statePublisher->recordVerifyError(0, i);
+        }
+    }
+}
+
+void PotentiometerManager::enableStatePublishing() {
+    if (statePublisher) return;
+    statePublisher.reset(new StatePublisher(mcpInterface.serialNumber()));
+    chainSet.setStatePublisher(statePublisher.get());
+}
+
+// Cycle d'écriture 50-TP : la chaîne ignore toute commande jusqu'à sa fin
+void PotentiometerManager::waitStoreCycle() {
+    double storeMicros;
+    {
+        std::lock_guard<std::mutex> lock(costModelMutex);
+        storeMicros = transferCostModel.storeTime();
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(static_cast<long long>(storeMicros)));
+}
+
+// Trames d'écriture envoyées directement : état à rejouer après reconnexion et cache
+void PotentiometerManager::recordProgrammedFrames(const uint8_t* frames) {
+    std::vector<uint16_t> values(NUM_POTS);
+    MCP2210Interface::decodeWriteFrames(frames, values.data());
+    mcpInterface.setReplayValues(values.data());
+    recordChainState(values, true);
 }
 
 std::vector<uint16_t> PotentiometerManager::readMemoryResistances() {
-    return mcpInterface.readMemoryResistances();
+    std::vector<uint16_t> values = mcpInterface.readMemoryResistances();
+    if (statePublisher) {
+        statePublisher->publishMemory(0, values);
+    }
+    return values;
 }
 
 void PotentiometerManager::programResistances(const std::vector<uint16_t>& values) {
-    if (values.size() != NUM_POTS) {
-        throw std::runtime_error("Le nombre de résistances ne correspond pas au nombre de potentiomètres.");
+    tryProgramResistances(values).valueOrThrow();
+}
+
+// La taille des valeurs est vérifiée une seule fois, par l'interface
+Expected<void> PotentiometerManager::tryProgramResistances(const std::vector<uint16_t>& values) {
+    // Invalidation avant l'envoi : en cas d'échec l'état réel est inconnu
+    invalidateCache();
+    Expected<void> result = mcpInterface.tryProgramResistances(values);
+    if (!result) {
+        recordWriteError(result.error());
+        return result;
     }
-    mcpInterface.programResistances(values);
+    recordChainState(values, true);
+    return result;
 }
 
-void PotentiometerManager::storeResistancesToMemory() {
-    mcpInterface.storeResistancesToMemory();
-}
\ No newline at end of file
+std::bitset<NUM_POTS> PotentiometerManager::programAndVerify(const std::vector<uint16_t>& values) {
+    return tryProgramAndVerify(values).valueOrThrow();
+}
+
+Expected<std::bitset<NUM_POTS>> PotentiometerManager::tryProgramAndVerify(const std::vector<uint16_t>& values) {
+    invalidateCache();
+    Expected<std::bitset<NUM_POTS>> result = mcpInterface.tryProgramAndVerify(values);
+    if (!result) {
+        recordWriteError(result.error());
+        return result;
+    }
+    const std::bitset<NUM_POTS>& mismatches = result.value();
+    recordVerifyErrors(mismatches);
+    if (mismatches.none()) {
+        recordChainState(values, true);
+    } else {
+        for (int i = 0; i < NUM_POTS; ++i) {
+            Metrics::global().recordPotWrite(i);
+        }
+    }
+    return result;
+}
+
+std::bitset<NUM_POTS> PotentiometerManager::storeResistancesToMemory() {
+    // Seuls les potentiomètres dont la valeur RDAC diffère de la mémoire consomment un emplacement 50-TP
+    std::vector<uint16_t> current = mcpInterface.readCurrentResistances();
+    std::vector<uint16_t> memory = mcpInterface.readMemoryResistances();
+    std::string serial = mcpInterface.serialNumber();
+    recordChainState(current, false);
+
+    std::bitset<NUM_POTS> pots;
+    for (int i = 0; i < NUM_POTS; ++i) {
+        pots[i] = (current[i] & RDAC_VALUE_MASK) != (memory[i] & RDAC_VALUE_MASK);
+        if (pots[i] && wearLedger.slotsLeft(serial, i) == 0) {
+            throw std::runtime_error("Mémoire 50-TP épuisée pour le potentiomètre #" + std::to_string(i + 1) + ".");
+        }
+    }
+
+    if (pots.none()) {
+        return pots;
+    }
+
+    mcpInterface.storeResistancesToMemory(pots);
+    waitStoreCycle();
+    for (int i = 0; i < NUM_POTS; ++i) {
+        if (pots[i]) {
+            wearLedger.recordStore(serial, i);
+            Metrics::global().recordPotStore(i);
+            memory[i] = current[i];
+        }
+    }
+    wearLedger.save();
+    if (statePublisher) {
+        statePublisher->publishMemory(0, memory);
+    }
+    return pots;
+}
+
+std::vector<unsigned int> PotentiometerManager::otpSlotsUsed() {
+    std::string serial = mcpInterface.serialNumber();
+    std::vector<unsigned int> used(NUM_POTS);
+    for (int i = 0; i < NUM_POTS; ++i) {
+        used[i] = wearLedger.slotsUsed(serial, i);
+    }
+    return used;
+}
+
+void PotentiometerManager::applyPreset(const PresetBank& bank, size_t index) {
+    // Trames déjà validées et encodées : un seul transfert pour toute la chaîne
+    programFrames(bank.frames(index));
+}
+
+void PotentiometerManager::programFrames(const uint8_t* frames) {
+    invalidateCache();
+    try {
+        mcpInterface.transferFrames(frames, CHAIN_TRANSFER_LENGTH);
+    } catch (...) {
+        recordWriteError();
+        throw;
+    }
+    recordProgrammedFrames(frames);
+}
+
+std::bitset<NUM_POTS> PotentiometerManager::executePlan(const OperationPlan& requested) {
+    // Comme storeResistancesToMemory : un stockage dont la mémoire contient déjà la valeur RDAC
+    // finale (écrite par le plan, sinon relue) est retiré du plan et ne consomme aucun emplacement
+    std::vector<PotPlan> pots = requested.pots();
+    std::string serial;
+    std::vector<uint16_t> memory;
+    std::bitset<NUM_POTS> skipped;
+    bool storing = false;
+    for (const PotPlan& pot : pots) storing = storing || pot.store;
+    if (storing) {
+        serial = mcpInterface.serialNumber();
+        memory = mcpInterface.readMemoryResistances();
+        std::vector<uint16_t> current;
+        for (int i = 0; i < NUM_POTS; ++i) {
+            if (pots[i].store && !pots[i].write && current.empty()) current = mcpInterface.readCurrentResistances();
+        }
+        for (int i = 0; i < NUM_POTS; ++i) {
+            if (!pots[i].store) continue;
+            uint16_t rdac = pots[i].write ? pots[i].value : current[i];
+            if ((rdac & RDAC_VALUE_MASK) == (memory[i] & RDAC_VALUE_MASK)) {
+                pots[i].store = false;
+                skipped.set(i);
+            } else if (wearLedger.slotsLeft(serial, i) == 0) {
+                throw std::runtime_error("Mémoire 50-TP épuisée pour le potentiomètre #" + std::to_string(i + 1) + ".");
+            } else {
+                memory[i] = rdac;
+            }
+        }
+    }
+    OperationPlan plan = skipped.any() ? OperationPlan::compile(pots) : requested;
+
+    invalidateCache();
+    std::bitset<NUM_POTS> mismatches;
+    bool stored = false;
+    for (const PlannedTransfer& transfer : plan.transfers()) {
+        std::vector<uint8_t> responseFrames(transfer.frames.size());
+        try {
+            mcpInterface.transferFrames(transfer.frames.data(), transfer.frames.size(), responseFrames.data());
+        } catch (...) {
+            recordWriteError();
+            throw;
+        }
+
+        // La réponse d'une trame de lecture se trouve dans la trame suivante
+        for (size_t frame : transfer.readFrames) {
+            const uint8_t* command = &transfer.frames[frame * CHAIN_FRAME_LENGTH];
+            const uint8_t* echo = &responseFrames[(frame + 1) * CHAIN_FRAME_LENGTH];
+            for (int i = 0; i < NUM_POTS; ++i) {
+                if (command[i * 2] != 0x08) continue;
+                uint16_t readBack = DefaultPotTraits::decodeValue(echo + i * 2);
+                mismatches[i] = (readBack & RDAC_VALUE_MASK) != pots[i].value;
+            }
+        }
+
+        if (transfer.stores.any()) {
+            for (int i = 0; i < NUM_POTS; ++i) {
+                if (transfer.stores[i]) {
+                    wearLedger.recordStore(serial, i);
+                    Metrics::global().recordPotStore(i);
+                }
+            }
+            stored = true;
+            waitStoreCycle();
+        }
+    }
+    if (stored) {
+        wearLedger.save();
+        if (statePublisher) {
+            statePublisher->publishMemory(0, memory);
+        }
+    }
+    recordVerifyErrors(mismatches);
+
+    // Valeurs rejouées après reconnexion et cache : uniquement si toute la chaîne est connue
+    bool allWritten = true;
+    std::vector<uint16_t> values(NUM_POTS);
+    for (int i = 0; i < NUM_POTS; ++i) {
+        allWritten = allWritten && pots[i].write;
+        values[i] = pots[i].value;
+    }
+    if (allWritten) {
+        mcpInterface.setReplayValues(values.data());
+        if (mismatches.none()) {
+            recordChainState(values, true);
+            return mismatches;
+        }
+    }
+    for (int i = 0; i < NUM_POTS; ++i) {
+        if (pots[i].write) Metrics::global().recordPotWrite(i);
+    }
+    return mismatches;
+}
+
+StreamStats PotentiometerManager::streamFrames(const uint8_t* frames, size_t count, std::chrono::microseconds period) {
+    StreamStats stats = {0, 0, 0.0, 0.0};
+    auto start = std::chrono::steady_clock::now();
+    invalidateCache();
+
+    for (size_t i = 0; i < count; ++i) {
+        // Échéances absolues : un retard ponctuel ne décale pas la suite du fondu
+        auto deadline = start + period * i;
+        auto now = std::chrono::steady_clock::now();
+        // Chaque trame partie après sa propre échéance compte : après un blocage,
+        // toutes les trames qui rattrapent le retard sont en retard
+        if (now < deadline) {
+            std::this_thread::sleep_until(deadline);
+        } else if (now > deadline) {
+            ++stats.framesLate;
+        }
+
+        Expected<void> sent = mcpInterface.tryTransferFrames(frames + i * CHAIN_TRANSFER_LENGTH, CHAIN_TRANSFER_LENGTH);
+        if (!sent) {
+            recordWriteError();
+            sent.valueOrThrow();
+        }
+        ++stats.framesDelivered;
+
+        // Publication de chaque étape : écriture en mémoire seulement, sans appel système
+        if (statePublisher) {
+            std::vector<uint16_t> values(NUM_POTS);
+            MCP2210Interface::decodeWriteFrames(frames + i * CHAIN_TRANSFER_LENGTH, values.data());
+            statePublisher->publishValues(0, values, true);
+        }
+    }
+
+    if (count > 0) {
+        recordProgrammedFrames(frames + (count - 1) * CHAIN_TRANSFER_LENGTH);
+    }
+
+    stats.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (stats.elapsedSeconds > 0.0) {
+        stats.updatesPerSecond = stats.framesDelivered / stats.elapsedSeconds;
+    }
+    return stats;
+}
+
+StreamStats PotentiometerManager::crossfade(const std::vector<uint16_t>& target, std::chrono::milliseconds duration,
+                                            TaperMode mode, unsigned int updateRate) {
+    MCP2210Interface::checkValues(target).valueOrThrow();
+    if (updateRate == 0) {
+        throw std::runtime_error("La fréquence de mise à jour doit être non nulle.");
+    }
+
+    size_t steps = static_cast<size_t>(duration.count()) * updateRate / 1000;
+    if (steps < 1) steps = 1;
+
+    Crossfade fade(readCurrentResistances(), target, steps, mode);
+    return streamFrames(fade.data(), fade.steps(), std::chrono::microseconds(1000000 / updateRate));
+}
+
+void PotentiometerManager::configureTriggerPin(unsigned int countMode) {
+    mcpInterface.configureTriggerPin(countMode);
+}
+
+TriggerResult PotentiometerManager::programOnTrigger(const std::vector<uint16_t>& values, std::chrono::milliseconds timeout,
+                                                     std::chrono::microseconds maxPollInterval) {
+    MCP2210Interface::checkValues(values).valueOrThrow();
+
+    // Trames encodées avant l'armement : seul le transfert reste à faire au déclenchement
+    uint8_t frames[CHAIN_TRANSFER_LENGTH] = {0};
+    MCP2210Interface::encodeWriteFrames(values.data(), frames);
+
+    TriggerResult result = {false, 0, 0.0, 0.0};
+    mcpInterface.readInterruptEvents(true); // Remise à zéro du compteur
+
+    auto previousPoll = std::chrono::steady_clock::now();
+    auto deadline = previousPoll + timeout;
+    std::chrono::microseconds backoff(0);
+
+    while (true) {
+        auto pollStart = std::chrono::steady_clock::now();
+        unsigned int events = mcpInterface.readInterruptEvents(false);
+        ++result.polls;
+
+        if (events > 0) {
+            invalidateCache();
+            mcpInterface.transferFrames(frames, CHAIN_TRANSFER_LENGTH);
+            auto done = std::chrono::steady_clock::now();
+            mcpInterface.setReplayValues(values.data());
+            recordChainState(values, true);
+
+            // Le front a eu lieu entre le sondage précédent et celui-ci
+            auto window = pollStart - previousPoll;
+            result.fired = true;
+            result.latencyMicros = std::chrono::duration<double, std::micro>(done - (previousPoll + window / 2)).count();
+            result.uncertaintyMicros = std::chrono::duration<double, std::micro>(window).count() / 2.0;
+            return result;
+        }
+
+        if (pollStart >= deadline) {
+            return result;
+        }
+        previousPoll = pollStart;
+
+        // Sondage serré au départ, puis espacé progressivement jusqu'à maxPollInterval
+        if (maxPollInterval.count() > 0) {
+            backoff = backoff.count() == 0 ? std::chrono::microseconds(50) : std::min(backoff * 2, maxPollInterval);
+            std::this_thread::sleep_for(backoff);
+        }
+    }
+}
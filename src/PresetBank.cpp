@@ -0,0 +1,201 @@
+#include "PresetBank.h"
+#include <stdexcept>
+#include <cstring>
+#include <fstream>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// En-tête du fichier de préréglages, suivi de recordCount PresetRecord
+struct PresetFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t numPots;
+    uint32_t recordCount;
+};
+
+static const char PRESET_FILE_MAGIC[4] = {'M', 'C', 'P', 'B'};
+static const uint32_t PRESET_FILE_VERSION = 1;
+
+PresetBank::PresetBank() : records(nullptr), recordCount(0), mappedBase(nullptr), mappedLength(0) {}
+
+PresetBank::~PresetBank() {
+    unmap();
+}
+
+void PresetBank::unmap() {
+#ifndef _WIN32
+    if (mappedBase) {
+        munmap(mappedBase, mappedLength);
+    }
+#endif
+    mappedBase = nullptr;
+    mappedLength = 0;
+}
+
+// Copie les préréglages projetés dans l'arène locale avant toute modification
+void PresetBank::makeOwned() {
+    if (!mappedBase) return;
+    ownedRecords.assign(records, records + recordCount);
+    unmap();
+    records = ownedRecords.data();
+}
+
+size_t PresetBank::addPreset(const std::string& name, const std::vector<uint16_t>& values) {
+    MCP2210Interface::checkValues(values).valueOrThrow();
+    if (name.empty() || name.size() >= PRESET_NAME_LENGTH) {
+        throw std::runtime_error("Erreur : nom de préréglage invalide.");
+    }
+
+    makeOwned();
+
+    // Un préréglage existant est remplacé, sinon il est ajouté à la fin de l'arène
+    int existing = findPreset(name);
+    size_t index = existing >= 0 ? static_cast<size_t>(existing) : ownedRecords.size();
+    if (existing < 0) {
+        ownedRecords.emplace_back();
+    }
+
+    PresetRecord& record = ownedRecords[index];
+    std::memset(&record, 0, sizeof(record));
+    std::memcpy(record.name, name.c_str(), name.size());
+    MCP2210Interface::encodeWriteFrames(values.data(), record.frames);
+
+    records = ownedRecords.data();
+    recordCount = ownedRecords.size();
+    return index;
+}
+
+int PresetBank::findPreset(const std::string& name) const {
+    for (size_t i = 0; i < recordCount; ++i) {
+        if (std::strncmp(records[i].name, name.c_str(), PRESET_NAME_LENGTH) == 0) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+const uint8_t* PresetBank::frames(size_t index) const {
+    if (index >= recordCount) {
+        throw std::runtime_error("Erreur : préréglage inexistant.");
+    }
+    return records[index].frames;
+}
+
+std::string PresetBank::name(size_t index) const {
+    if (index >= recordCount) {
+        throw std::runtime_error("Erreur : préréglage inexistant.");
+    }
+    return std::string(records[index].name, strnlen(records[index].name, PRESET_NAME_LENGTH));
+}
+
+size_t PresetBank::size() const {
+    return recordCount;
+}
+
+void PresetBank::save(const std::string& path) const {
+    // Écriture dans un fichier voisin puis renommage : un lecteur qui projette la
+    // banque garde l'ancienne version, une interruption laisse la banque intacte
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Erreur : impossible d'écrire le fichier de préréglages.");
+        }
+
+        PresetFileHeader header;
+        std::memcpy(header.magic, PRESET_FILE_MAGIC, sizeof(header.magic));
+        header.version = PRESET_FILE_VERSION;
+        header.numPots = NUM_POTS;
+        header.recordCount = static_cast<uint32_t>(recordCount);
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(records), recordCount * sizeof(PresetRecord));
+        file.flush();
+        file.close();
+        if (!file) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Erreur : écriture du fichier de préréglages incomplète.");
+        }
+    }
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Erreur : impossible de remplacer le fichier de préréglages.");
+    }
+}
+
+static void checkHeader(const PresetFileHeader& header, size_t fileLength) {
+    if (std::memcmp(header.magic, PRESET_FILE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != PRESET_FILE_VERSION
+        || header.numPots != NUM_POTS
+        || fileLength != sizeof(PresetFileHeader) + header.recordCount * sizeof(PresetRecord)) {
+        throw std::runtime_error("Erreur : fichier de préréglages invalide.");
+    }
+}
+
+void PresetBank::load(const std::string& path) {
+    unmap();
+    ownedRecords.clear();
+    records = nullptr;
+    recordCount = 0;
+
+#ifndef _WIN32
+    // Projection en lecture seule : les pages ne sont chargées qu'à l'application d'un préréglage
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Erreur : impossible d'ouvrir le fichier de préréglages.");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(PresetFileHeader)) {
+        close(fd);
+        throw std::runtime_error("Erreur : fichier de préréglages invalide.");
+    }
+
+    void* base = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("Erreur : projection du fichier de préréglages impossible.");
+    }
+
+    const PresetFileHeader* header = static_cast<const PresetFileHeader*>(base);
+    try {
+        checkHeader(*header, st.st_size);
+    } catch (...) {
+        munmap(base, st.st_size);
+        throw;
+    }
+
+    mappedBase = base;
+    mappedLength = st.st_size;
+    records = reinterpret_cast<const PresetRecord*>(header + 1);
+    recordCount = header->recordCount;
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Erreur : impossible d'ouvrir le fichier de préréglages.");
+    }
+
+    size_t fileLength = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+
+    PresetFileHeader header;
+    if (fileLength < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        throw std::runtime_error("Erreur : fichier de préréglages invalide.");
+    }
+    checkHeader(header, fileLength);
+
+    ownedRecords.resize(header.recordCount);
+    file.read(reinterpret_cast<char*>(ownedRecords.data()), header.recordCount * sizeof(PresetRecord));
+    records = ownedRecords.data();
+    recordCount = ownedRecords.size();
+#endif
+}
@@ -0,0 +1,276 @@
+#include "StateSnapshot.h"
+#include <stdexcept>
+#include <cstring>
+#include <chrono>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define STATE_PUBLISHER_OPEN_ATTEMPTS 10
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "le seqlock partagé exige un atomique sans verrou");
+
+static int64_t systemNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string StatePublisher::segmentName(const std::string& serial) {
+#ifdef _WIN32
+    return "Local\\mcp2210-state-" + serial;
+#else
+    return "/mcp2210-state-" + serial;
+#endif
+}
+
+#ifndef _WIN32
+// Segment ouvert et verrouillé en écriture exclusive. Un segment supprimé par l'écrivain
+// précédent entre l'ouverture et le verrou est abandonné pour celui qui porte désormais le nom.
+static int openLockedSegment(const std::string& name) {
+    for (int attempt = 0; attempt < STATE_PUBLISHER_OPEN_ATTEMPTS; ++attempt) {
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Erreur : création du segment d'état partagé impossible.");
+        }
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            int error = errno;
+            close(fd);
+            if (error == EWOULDBLOCK) {
+                throw std::runtime_error("Erreur : l'état de cet adaptateur est déjà publié par un autre processus.");
+            }
+            throw std::runtime_error("Erreur : verrouillage du segment d'état partagé impossible.");
+        }
+
+        int current = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        struct stat locked;
+        struct stat named;
+        bool same = current >= 0 && fstat(fd, &locked) == 0 && fstat(current, &named) == 0
+                    && locked.st_dev == named.st_dev && locked.st_ino == named.st_ino;
+        if (current >= 0) close(current);
+        if (same) {
+            return fd;
+        }
+        close(fd);
+    }
+    throw std::runtime_error("Erreur : segment d'état partagé instable.");
+}
+#endif
+
+StatePublisher::StatePublisher(const std::string& serial) : name(segmentName(serial)), segment(nullptr) {
+    void* base = nullptr;
+#ifdef _WIN32
+    writerLock = CreateMutexA(NULL, FALSE, (name + "-writer").c_str());
+    if (writerLock == NULL) {
+        throw std::runtime_error("Erreur : verrouillage du segment d'état partagé impossible.");
+    }
+    DWORD wait = WaitForSingleObject(writerLock, 0);
+    if (wait != WAIT_OBJECT_0 && wait != WAIT_ABANDONED) {
+        CloseHandle(writerLock);
+        throw std::runtime_error("Erreur : l'état de cet adaptateur est déjà publié par un autre processus.");
+    }
+    mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(StateSegment), name.c_str());
+    if (mapping == NULL) {
+        ReleaseMutex(writerLock);
+        CloseHandle(writerLock);
+        throw std::runtime_error("Erreur : création du segment d'état partagé impossible.");
+    }
+    base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(StateSegment));
+    if (base == NULL) {
+        CloseHandle(mapping);
+        ReleaseMutex(writerLock);
+        CloseHandle(writerLock);
+        throw std::runtime_error("Erreur : projection du segment d'état partagé impossible.");
+    }
+#else
+    fd = openLockedSegment(name);
+    if (ftruncate(fd, sizeof(StateSegment)) != 0) {
+        close(fd);
+        throw std::runtime_error("Erreur : dimensionnement du segment d'état partagé impossible.");
+    }
+    base = mmap(nullptr, sizeof(StateSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Erreur : projection du segment d'état partagé impossible.");
+    }
+#endif
+    segment = static_cast<StateSegment*>(base);
+
+    // Segment neuf : en-tête écrit en dernier. Segment laissé par un écrivain précédent : remis à zéro
+    // sous le seqlock, la séquence repartant d'une valeur paire même si cet écrivain est mort en pleine
+    // mise à jour (séquence restée impaire).
+    if (segment->magic != STATE_SNAPSHOT_MAGIC || segment->version != STATE_SNAPSHOT_VERSION) {
+        std::memset(static_cast<void*>(segment), 0, sizeof(StateSegment));
+        new (&segment->sequence) std::atomic<uint32_t>(0);
+        segment->version = STATE_SNAPSHOT_VERSION;
+        std::atomic_thread_fence(std::memory_order_release);
+        segment->magic = STATE_SNAPSHOT_MAGIC;
+    } else {
+        uint32_t updating = segment->sequence.load(std::memory_order_relaxed) | 1;
+        segment->sequence.store(updating, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memset(&segment->snapshot, 0, sizeof(StateSnapshot));
+        segment->snapshot.publishedNanos = systemNanos();
+        segment->sequence.store(updating + 1, std::memory_order_release);
+    }
+}
+
+StatePublisher::~StatePublisher() {
+#ifdef _WIN32
+    UnmapViewOfFile(segment);
+    CloseHandle(mapping);
+    ReleaseMutex(writerLock);
+    CloseHandle(writerLock);
+#else
+    // Plus d'écrivain : l'état n'est plus garanti, le segment disparaît. Le nom est retiré
+    // pendant que le verrou exclusif est encore tenu, jamais celui d'un autre écrivain.
+    munmap(segment, sizeof(StateSegment));
+    shm_unlink(name.c_str());
+    close(fd);
+#endif
+}
+
+void StatePublisher::begin() {
+    segment->sequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void StatePublisher::end() {
+    segment->snapshot.publishedNanos = systemNanos();
+    segment->sequence.fetch_add(1, std::memory_order_release);
+}
+
+ChainState& StatePublisher::chainState(size_t chain, size_t length) {
+    if (length > MAX_CHAIN_LENGTH) {
+        throw std::runtime_error("Erreur : chaîne hors du segment d'état partagé.");
+    }
+    StateSnapshot& snapshot = segment->snapshot;
+    if (snapshot.chainCount <= chain) {
+        snapshot.chainCount = static_cast<uint32_t>(chain + 1);
+    }
+    if (snapshot.chains[chain].length < length) {
+        snapshot.chains[chain].length = static_cast<uint32_t>(length);
+    }
+    return snapshot.chains[chain];
+}
+
+void StatePublisher::publishValues(size_t chain, const std::vector<uint16_t>& values, bool written) {
+    if (chain >= STATE_SNAPSHOT_MAX_CHAINS) return;
+    std::lock_guard<std::mutex> lock(writerMutex);
+    int64_t now = written ? systemNanos() : 0;
+    begin();
+    ChainState& state = chainState(chain, values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        state.pots[i].rdac = values[i];
+        state.pots[i].flags |= POT_STATE_RDAC_KNOWN;
+        if (written) {
+            state.pots[i].lastWriteNanos = now;
+        }
+    }
+    end();
+}
+
+void StatePublisher::publishMemory(size_t chain, const std::vector<uint16_t>& values) {
+    if (chain >= STATE_SNAPSHOT_MAX_CHAINS) return;
+    std::lock_guard<std::mutex> lock(writerMutex);
+    begin();
+    ChainState& state = chainState(chain, values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        state.pots[i].memory = values[i];
+        state.pots[i].flags |= POT_STATE_MEMORY_KNOWN;
+    }
+    end();
+}
+
+void StatePublisher::recordVerifyError(size_t chain, size_t position) {
+    if (chain >= STATE_SNAPSHOT_MAX_CHAINS) return;
+    std::lock_guard<std::mutex> lock(writerMutex);
+    begin();
+    ++chainState(chain, position + 1).pots[position].verifyErrors;
+    end();
+}
+
+void StatePublisher::recordWriteError(size_t chain) {
+    if (chain >= STATE_SNAPSHOT_MAX_CHAINS) return;
+    std::lock_guard<std::mutex> lock(writerMutex);
+    begin();
+    ChainState& state = chainState(chain, 0);
+    for (uint32_t i = 0; i < state.length; ++i) {
+        ++state.pots[i].writeErrors;
+    }
+    ++segment->snapshot.transferErrors;
+    end();
+}
+
+StateSnapshotReader::StateSnapshotReader(const std::string& serial) : segment(nullptr) {
+    std::string name = StatePublisher::segmentName(serial);
+    const void* base = nullptr;
+#ifdef _WIN32
+    mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+    if (mapping == NULL) {
+        throw std::runtime_error("Erreur : aucun état publié pour cet adaptateur.");
+    }
+    base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(StateSegment));
+    if (base == NULL) {
+        CloseHandle(mapping);
+        throw std::runtime_error("Erreur : projection du segment d'état partagé impossible.");
+    }
+#else
+    int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Erreur : aucun état publié pour cet adaptateur.");
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(StateSegment)) {
+        close(fd);
+        throw std::runtime_error("Erreur : segment d'état partagé invalide.");
+    }
+    base = mmap(nullptr, sizeof(StateSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("Erreur : projection du segment d'état partagé impossible.");
+    }
+#endif
+    segment = static_cast<const StateSegment*>(base);
+
+    if (segment->magic != STATE_SNAPSHOT_MAGIC || segment->version != STATE_SNAPSHOT_VERSION) {
+#ifdef _WIN32
+        UnmapViewOfFile(base);
+        CloseHandle(mapping);
+#else
+        munmap(const_cast<void*>(base), sizeof(StateSegment));
+#endif
+        throw std::runtime_error("Erreur : segment d'état partagé invalide.");
+    }
+}
+
+StateSnapshotReader::~StateSnapshotReader() {
+#ifdef _WIN32
+    UnmapViewOfFile(segment);
+    CloseHandle(mapping);
+#else
+    munmap(const_cast<StateSegment*>(segment), sizeof(StateSegment));
+#endif
+}
+
+bool StateSnapshotReader::read(StateSnapshot& snapshot, unsigned int maxRetries) const {
+    for (unsigned int attempt = 0; attempt < maxRetries; ++attempt) {
+        uint32_t before = segment->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue; // Mise à jour en cours
+        }
+        std::memcpy(&snapshot, &segment->snapshot, sizeof(StateSnapshot));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (segment->sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
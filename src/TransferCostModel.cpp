@@ -0,0 +1,132 @@
+#include "TransferCostModel.h"
+#include "MCP2210Interface.h"
+#include <cmath>
+#include <algorithm>
+
+// Paramètres de démarrage du MCP2210 tant que les vrais paramètres ne sont pas connus
+static SPITransferSettingsDef defaultSettings() {
+    SPITransferSettingsDef settings = SPITransferSettingsDef();
+    settings.BitRate = 1000000;
+    settings.CSToDataDelay = 1;
+    settings.LastDataByteToCSDelay = 1;
+    settings.SubsequentDataByteDelay = 1;
+    settings.BytesPerSPITransfer = CHAIN_TRANSFER_LENGTH;
+    return settings;
+}
+
+TransferCostModel::TransferCostModel()
+    : settings(defaultSettings()), roundTripMicros(DEFAULT_USB_ROUND_TRIP_US), storeMicros(DEFAULT_OTP_STORE_TIME_US),
+      pollLimit(DefaultSPITransferPolicy().MaxPolls), observedPolls(0), samples(0) {}
+
+TransferCostModel::TransferCostModel(const SPITransferSettingsDef& settings, double roundTripMicros)
+    : settings(settings), roundTripMicros(roundTripMicros), storeMicros(DEFAULT_OTP_STORE_TIME_US),
+      pollLimit(DefaultSPITransferPolicy().MaxPolls), observedPolls(0), samples(0) {}
+
+void TransferCostModel::setSettings(const SPITransferSettingsDef& newSettings) {
+    settings = newSettings;
+}
+
+void TransferCostModel::setRoundTrip(double micros) {
+    roundTripMicros = micros;
+}
+
+void TransferCostModel::setStoreTime(double micros) {
+    storeMicros = micros;
+}
+
+void TransferCostModel::setPollLimit(unsigned int maxPolls) {
+    pollLimit = maxPolls;
+}
+
+double TransferCostModel::roundTrip() const {
+    return roundTripMicros;
+}
+
+double TransferCostModel::storeTime() const {
+    return storeMicros;
+}
+
+// Durée sur le bus : délais CS (x100 ns) par fenêtre, bits à la vitesse SPI, délais entre octets
+double TransferCostModel::spiMicros(size_t bytes) const {
+    if (bytes == 0) return 0.0;
+
+    size_t perWindow = settings.BytesPerSPITransfer > 0 ? settings.BytesPerSPITransfer : bytes;
+    size_t windows = (bytes + perWindow - 1) / perWindow;
+    double bitRate = settings.BitRate > 0 ? static_cast<double>(settings.BitRate) : 1000000.0; // Paramètres non valides : 1 MHz
+
+    double csDelays = windows * (settings.CSToDataDelay + settings.LastDataByteToCSDelay) * 0.1;
+    double interByte = (bytes - windows) * settings.SubsequentDataByteDelay * 0.1;
+    double bits = bytes * 8.0 * 1e6 / bitRate;
+    return csDelays + interByte + bits;
+}
+
+// Rapports d'envoi des données, rapport qui rend les données reçues, et entre les deux un
+// sondage « transfert en cours » par aller-retour entièrement écoulé sur le bus. Ces sondages
+// sont bornés par la politique et, une fois calibré, par ce que le moteur a réellement rendu.
+unsigned int TransferCostModel::reportsFor(size_t bytes) const {
+    unsigned int dataReports = static_cast<unsigned int>((bytes + SPI_REPORT_PAYLOAD - 1) / SPI_REPORT_PAYLOAD);
+    double polls = roundTripMicros > 0.0 ? std::floor(spiMicros(bytes) / roundTripMicros) : 0.0;
+    if (pollLimit > 0) {
+        polls = std::min(polls, static_cast<double>(pollLimit));
+    }
+    if (samples > 0) {
+        polls = std::min(polls, static_cast<double>(observedPolls));
+    }
+    return std::max(dataReports, 1u) + 1 + static_cast<unsigned int>(polls);
+}
+
+// Les sondages ne couvrent que des allers-retours entiers : le temps de bus reste un minimum
+double TransferCostModel::transferMicros(size_t bytes) const {
+    return std::max(reportsFor(bytes) * roundTripMicros, spiMicros(bytes) + roundTripMicros);
+}
+
+CostEstimate TransferCostModel::estimateTransfers(const std::vector<size_t>& transferSizes) const {
+    CostEstimate estimate = {0, 0, 0.0, 0.0};
+    for (size_t bytes : transferSizes) {
+        ++estimate.transfers;
+        estimate.reports += reportsFor(bytes);
+        estimate.spiMicros += spiMicros(bytes);
+        estimate.totalMicros += transferMicros(bytes);
+    }
+    return estimate;
+}
+
+CostEstimate TransferCostModel::estimate(ChainOperation operation) const {
+    switch (operation) {
+    case ChainOperation::Read:
+    case ChainOperation::ReadMemory:
+    case ChainOperation::Program:
+    case ChainOperation::Preset:
+        return estimateTransfers({CHAIN_TRANSFER_LENGTH});
+    case ChainOperation::ProgramAndVerify:
+        if (CHAIN_FRAME_LENGTH * 3 <= SPI_REPORT_PAYLOAD) {
+            return estimateTransfers({CHAIN_FRAME_LENGTH * 3});
+        }
+        return estimateTransfers({CHAIN_FRAME_LENGTH, CHAIN_FRAME_LENGTH * 2});
+    case ChainOperation::Store: {
+        // Relecture RDAC et mémoire, stockage, puis cycle d'écriture 50-TP du circuit
+        CostEstimate estimate = estimateTransfers({CHAIN_TRANSFER_LENGTH, CHAIN_TRANSFER_LENGTH, CHAIN_TRANSFER_LENGTH});
+        estimate.totalMicros += storeMicros;
+        return estimate;
+    }
+    }
+    return CostEstimate{0, 0, 0.0, 0.0};
+}
+
+// Moyenne glissante du temps d'aller-retour USB : durée mesurée divisée par les rapports
+// effectivement échangés (sondages + rapport final), indépendante du modèle lui-même.
+// Les transferts ralentis par un bus occupé incluent des attentes et sont écartés.
+void TransferCostModel::calibrate(const SPITransferOutcomeDef& outcome) {
+    if (outcome.Outcome != SPI_TRANSFER_COMPLETED || outcome.BusyReplies > 0 || outcome.ElapsedMicros <= 0.0) return;
+
+    // Polls compte l'acceptation des données (0x20) puis chaque réponse « en cours » (0x30)
+    double sample = outcome.ElapsedMicros / (outcome.Polls + 1);
+    unsigned int inProgress = outcome.Polls > 0 ? outcome.Polls - 1 : 0;
+    observedPolls = samples == 0 ? inProgress : std::max(observedPolls, inProgress);
+    roundTripMicros = samples == 0 ? sample : 0.8 * roundTripMicros + 0.2 * sample;
+    ++samples;
+}
+
+unsigned long TransferCostModel::calibrationSamples() const {
+    return samples;
+}
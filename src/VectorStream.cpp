@@ -0,0 +1,109 @@
+#include "VectorStream.h"
+#include "MCP2210Interface.h"
+#include <stdexcept>
+#include <cstring>
+#include <charconv>
+#include <string>
+
+VectorStreamParser::VectorStreamParser(std::FILE* input, VectorFormat format, size_t vectorLength)
+    : input(input), format(format), vectorLength(vectorLength), buffer(VECTOR_STREAM_BUFFER_SIZE),
+      begin(0), end(0), eof(false), lineNumber(0), vectors(0) {}
+
+// Décale les octets non consommés en tête du tampon, puis le complète depuis le flux
+bool VectorStreamParser::fill() {
+    if (eof) return false;
+    if (begin > 0) {
+        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    size_t read = std::fread(buffer.data() + end, 1, buffer.size() - end, input);
+    end += read;
+    if (read == 0) {
+        eof = true;
+    }
+    return read > 0;
+}
+
+bool VectorStreamParser::next(uint16_t* values) {
+    bool found = format == VectorFormat::Binary ? nextBinary(values) : nextText(values);
+    if (found) {
+        ++vectors;
+    }
+    return found;
+}
+
+unsigned long VectorStreamParser::vectorsRead() const {
+    return vectors;
+}
+
+bool VectorStreamParser::nextBinary(uint16_t* values) {
+    size_t bytes = vectorLength * 2;
+    while (end - begin < bytes) {
+        if (!fill()) {
+            if (end != begin) {
+                throw std::runtime_error("Erreur : vecteur binaire incomplet en fin de flux.");
+            }
+            return false;
+        }
+    }
+
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(buffer.data() + begin);
+    for (size_t i = 0; i < vectorLength; ++i) {
+        values[i] = static_cast<uint16_t>(data[i * 2] | (data[i * 2 + 1] << 8));
+        if (values[i] > RDAC_VALUE_MASK) {
+            throw std::runtime_error("Erreur : valeur hors limites dans le vecteur " + std::to_string(vectors + 1) + ".");
+        }
+    }
+    begin += bytes;
+    return true;
+}
+
+bool VectorStreamParser::nextText(uint16_t* values) {
+    while (true) {
+        const char* first = buffer.data() + begin;
+        const char* newline = static_cast<const char*>(std::memchr(first, '\n', end - begin));
+        if (!newline) {
+            if (begin == 0 && end == buffer.size()) {
+                throw std::runtime_error("Erreur : ligne trop longue dans le flux de vecteurs.");
+            }
+            if (fill()) continue;
+            if (begin == end) return false;
+            newline = buffer.data() + end; // Dernière ligne sans fin de ligne
+            first = buffer.data() + begin;
+        }
+
+        ++lineNumber;
+        const char* last = newline;
+        begin = static_cast<size_t>(newline - buffer.data()) + (newline < buffer.data() + end ? 1 : 0);
+
+        // Lignes vides et commentaires ignorés
+        const char* p = first;
+        while (p < last && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+        if (p == last || *p == '#') continue;
+
+        parseLine(p, last, values);
+        return true;
+    }
+}
+
+void VectorStreamParser::parseLine(const char* first, const char* last, uint16_t* values) {
+    size_t count = 0;
+    const char* p = first;
+    while (p < last) {
+        if (*p == ' ' || *p == ',' || *p == ';' || *p == '\t' || *p == '\r') {
+            ++p;
+            continue;
+        }
+        unsigned int value = 0;
+        std::from_chars_result result = std::from_chars(p, last, value);
+        if (result.ec != std::errc() || count == vectorLength || value > RDAC_VALUE_MASK) {
+            throw std::runtime_error("Erreur : vecteur invalide ligne " + std::to_string(lineNumber) + ".");
+        }
+        values[count++] = static_cast<uint16_t>(value);
+        p = result.ptr;
+    }
+    if (count != vectorLength) {
+        throw std::runtime_error("Erreur : vecteur incomplet ligne " + std::to_string(lineNumber) + ".");
+    }
+}
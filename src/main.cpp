@@ -1,60 +1,1006 @@
 #include <iostream>
 #include <vector>
 #include "PotentiometerManager.h"
+#include "LatencyRecorder.h"
+#include "HealthMonitor.h"
+#include "CommandScheduler.h"
+#include "FrameRing.h"
+#include "VectorStream.h"
+#include "MCP2210Simulator.h"
+#include "Benchmark.h"
+#include "Metrics.h"
+#include "MCP2210Transport.h"
+#include <thread>
 #include <string>
+#include <fstream>
+#include <stdexcept>
+#include <sstream>
+#include <cstdio>
+#include <cctype>
+#include <memory>
+#include <algorithm>
+#include "DevicePathCache.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
 
 void printHelp() {
-    std::cout << "Usage: mcp2210_cli [options]\n"
+    std::cout << "Usage: mcp2210_cli [--lock <ms> [--external-master]] [--publish-state] [--simulate [latence_us]]\n"
+              << "                   [--metrics-listen <port|unix:chemin>] [--metrics-file <chemin> [période_s]]\n"
+              << "                   [--spi-timeout <ms> [sondages_max]] [--fast-open [fichier]]\n"
+              << "                   [--record <fichier> | --replay <fichier>] [options]\n"
+              << "Options globales :\n"
+              << "  --lock <ms>            Verrou exclusif de l'adaptateur par transaction (attente max en ms)\n"
+              << "  --external-master      Attendre puis rendre le bus SPI à un maître externe\n"
+              << "  --publish-state        Publier l'état des chaînes en mémoire partagée\n"
+              << "  --simulate [latence_us]\n"
+              << "                         Utiliser un MCP2210 simulé (latence fixe par rapport USB)\n"
+              << "  --metrics-listen <port|unix:chemin>\n"
+              << "                         Exposer les métriques Prometheus en HTTP sur 127.0.0.1 ou une socket Unix\n"
+              << "  --metrics-file <chemin> [période_s]\n"
+              << "                         Réécrire les métriques dans un fichier (collecteur textfile, 15 s par défaut)\n"
+              << "  --spi-timeout <ms> [sondages_max]\n"
+              << "                         Délai maximal d'un transfert SPI (1000 ms et 1000 sondages par défaut),\n"
+              << "                         le transfert expiré est annulé\n"
+              << "  --fast-open [fichier]  Rouvrir l'adaptateur par son chemin hidraw mémorisé, sans énumération\n"
+              << "                         (" << DEVICE_PATH_CACHE_FILE << " par défaut)\n"
+              << "  --record <fichier>     Enregistrer chaque rapport USB échangé (adaptateur ou simulateur)\n"
+              << "  --replay <fichier>     Rejouer un enregistrement à la place de l'adaptateur\n"
               << "Options:\n"
               << "  --read-current         Lire les résistances actuelles\n"
               << "  --read-memory          Lire les résistances stockées en mémoire\n"
               << "  --set [values...]      Programmer des résistances (valeurs séparées par des espaces)\n"
+              << "  --set-stream [text|binary] [profondeur]\n"
+              << "                         Programmer chaque vecteur lu sur l'entrée standard (lignes CSV\n"
+              << "                         ou NUM_POTS entiers 16 bits little-endian), lecture et envoi en parallèle\n"
+              << "  --set-verify [values...]\n"
+              << "                         Programmer puis relire les résistances en une transaction\n"
               << "  --store                Stocker les résistances programmées en mémoire\n"
+              << "                         (uniquement les potentiomètres modifiés)\n"
+              << "  --wear                 Afficher les emplacements 50-TP utilisés\n"
+              << "  --preset-save <fichier> <nom> [values...]\n"
+              << "                         Enregistrer un préréglage (trames pré-encodées)\n"
+              << "  --preset-apply <fichier> <nom>\n"
+              << "                         Appliquer un préréglage en un seul transfert SPI\n"
+              << "  --fade <ms> <lin|log> [values...]\n"
+              << "                         Fondu progressif vers les valeurs données\n"
+              << "  --trigger <n> <timeout_ms> [values...]\n"
+              << "                         Programmer à chaque front sur GP6 (n fois) et mesurer la latence\n"
+              << "  --gpio-read            Lire les GPIO (masque GP8..GP0)\n"
+              << "  --gpio-set <masque> <valeurs>\n"
+              << "                         Modifier les sorties GPIO du masque en une commande\n"
+              << "  --gpio-toggle <masque> Inverser les sorties GPIO du masque\n"
+              << "  --chains <cs>[@famille,...]:<v1,v2,...> [...]\n"
+              << "                         Programmer plusieurs chaînes, chacune sur son masque CS\n"
+              << "                         (familles : ad5270, ad5271, mcp42010 ; ad5270 par défaut) ;\n"
+              << "                         dans un script, chaque commande remplace les chaînes de la précédente\n"
+              << "  --monitor <s>          Surveiller l'adaptateur pendant s secondes (reconnexion automatique)\n"
+              << "  --sched-check <n> [values...]\n"
+              << "                         n écritures temps réel pendant un dump EEPROM, latence par file\n"
+              << "  --plan [--dry-run] <étapes> [values...]\n"
+              << "                         Compiler les étapes (enable,write,verify,store) en un minimum de\n"
+              << "                         transferts ; '-' laisse un potentiomètre inchangé\n"
+              << "  --estimate [n]         Estimer la durée de chaque opération (n mesures d'aller-retour USB)\n"
+              << "  --bench [n] [--bitrates a,b,..] [--lengths a,b,..] [--json <fichier|->]\n"
+              << "                         Mesurer les opérations de référence (n itérations) pour chaque débit\n"
+              << "  --script <fichier|->   Exécuter une suite de commandes avec un seul accès à l'adaptateur\n"
+              << "                         (read, set, set-one, store, sleep, verify, gpio-*, autres options sans --)\n"
+              << "  --repl                 Mode interactif, mêmes commandes que --script, adaptateur surveillé\n"
+              << "  --snapshot <série>     Lire l'état publié par un autre processus (sans accès USB)\n"
               << "  --help                 Afficher l'aide\n";
 }
 
+std::vector<uint16_t> parseValues(int argc, char* argv[], int first) {
+    std::vector<uint16_t> values;
+    for (int i = first; i < argc; ++i) {
+        values.push_back(static_cast<uint16_t>(std::stoi(argv[i])));
+    }
+    return values;
+}
+
+// Ajout d'un préréglage au fichier (créé s'il n'existe pas), sans ouvrir le MCP2210
+int savePreset(int argc, char* argv[]) {
+    if (argc < 5) {
+        std::cerr << "Erreur : usage --preset-save <fichier> <nom> [values...]\n";
+        return 1;
+    }
+
+    try {
+        PresetBank bank;
+        if (std::ifstream(argv[2]).good()) {
+            bank.load(argv[2]);
+        }
+        bank.addPreset(argv[3], parseValues(argc, argv, 4));
+        bank.save(argv[2]);
+    } catch (const std::exception& e) {
+        std::cerr << "Erreur : " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+int showSnapshot(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Erreur : usage --snapshot <série>\n";
+        return 1;
+    }
+
+    try {
+        StateSnapshotReader reader(argv[2]);
+        StateSnapshot snapshot;
+        if (!reader.read(snapshot)) {
+            std::cerr << "Erreur : état en cours de mise à jour, réessayer\n";
+            return 1;
+        }
+
+        std::cout << "Transferts en échec : " << snapshot.transferErrors << "\n";
+        for (uint32_t c = 0; c < snapshot.chainCount; ++c) {
+            const ChainState& chain = snapshot.chains[c];
+            std::cout << "Chaîne " << c << " :\n";
+            for (uint32_t i = 0; i < chain.length; ++i) {
+                const PotState& pot = chain.pots[i];
+                std::cout << "  Potentiomètre #" << i + 1 << ": RDAC ";
+                if (pot.flags & POT_STATE_RDAC_KNOWN) std::cout << pot.rdac; else std::cout << "?";
+                std::cout << ", mémoire ";
+                if (pot.flags & POT_STATE_MEMORY_KNOWN) std::cout << pot.memory; else std::cout << "?";
+                if (pot.lastWriteNanos != 0) {
+                    double age = (std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::system_clock::now().time_since_epoch()).count() - pot.lastWriteNanos) / 1e9;
+                    std::cout << ", écrit il y a " << age << " s";
+                }
+                std::cout << ", erreurs écriture " << pot.writeErrors << ", vérification " << pot.verifyErrors << "\n";
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Erreur : " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Étapes communes (enable,write,verify,store) appliquées aux potentiomètres dont la valeur n'est pas '-'
+OperationPlan buildPlan(int argc, char* argv[], int first) {
+    if (first >= argc) {
+        throw std::runtime_error("aucune étape fournie pour --plan");
+    }
+
+    bool enable = false, write = false, verify = false, store = false;
+    std::string steps = argv[first];
+    size_t start = 0;
+    while (start <= steps.size()) {
+        size_t end = steps.find(',', start);
+        std::string step = steps.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        if (step == "enable") enable = true;
+        else if (step == "write") write = true;
+        else if (step == "verify") verify = true;
+        else if (step == "store") store = true;
+        else throw std::runtime_error("étape inconnue : " + step);
+        if (end == std::string::npos) break;
+        start = end + 1;
+    }
+
+    int valueCount = argc - first - 1;
+    if ((write || verify) && valueCount != NUM_POTS) {
+        throw std::runtime_error("le nombre de valeurs ne correspond pas au nombre de potentiomètres.");
+    }
+
+    std::vector<PotPlan> pots(NUM_POTS);
+    for (int i = 0; i < NUM_POTS; ++i) {
+        bool skipped = i < valueCount && std::string(argv[first + 1 + i]) == "-";
+        pots[i].enableWrite = enable && !skipped;
+        pots[i].write = write && !skipped;
+        pots[i].value = (i < valueCount && !skipped) ? static_cast<uint16_t>(std::stoi(argv[first + 1 + i])) : 0;
+        pots[i].verify = verify && !skipped;
+        pots[i].store = store && !skipped;
+    }
+    return OperationPlan::compile(pots);
+}
+
+// Exécute une commande (argv[1]) sur un gestionnaire déjà ouvert ; partagé par la ligne de commande et les scripts
+int runCommand(PotentiometerManager& manager, int argc, char* argv[]) {
+    std::string command = argv[1];
+    if (command == "--read-current") {
+        auto resistances = manager.refreshCurrentResistances();
+        for (size_t i = 0; i < resistances.size(); ++i) {
+            std::cout << "Potentiomètre #" << i + 1 << ": " << resistances[i] << " ohms\n";
+        }
+    } else if (command == "--read-memory") {
+        auto resistances = manager.readMemoryResistances();
+        for (size_t i = 0; i < resistances.size(); ++i) {
+            std::cout << "Potentiomètre #" << i + 1 << ": " << resistances[i] << " ohms\n";
+        }
+    } else if (command == "--set") {
+        if (argc < 3) {
+            std::cerr << "Erreur : aucune valeur fournie pour --set\n";
+            return 1;
+        }
+        manager.programResistances(parseValues(argc, argv, 2));
+    } else if (command == "--set-stream") {
+        std::string format = argc >= 3 ? argv[2] : "text";
+        if (format != "text" && format != "binary") {
+            std::cerr << "Erreur : format inconnu \"" << format << "\" (text ou binary)\n";
+            return 1;
+        }
+        size_t depth = argc >= 4 ? std::stoul(argv[3]) : FRAME_RING_DEFAULT_DEPTH;
+#ifdef _WIN32
+        if (format == "binary") {
+            _setmode(_fileno(stdin), _O_BINARY);
+        }
+#endif
+
+        // Lecture et encodage dans un thread, envoi USB dans celui-ci ; la file bornée régule le lecteur
+        FrameRing ring(depth);
+        std::string readerError;
+        std::thread reader([&]() {
+            try {
+                VectorStreamParser parser(stdin, format == "binary" ? VectorFormat::Binary : VectorFormat::Text, NUM_POTS);
+                uint16_t values[NUM_POTS];
+                while (uint8_t* slot = ring.acquireSlot()) {
+                    if (!parser.next(values)) break;
+                    MCP2210Interface::encodeWriteFrames(values, slot); // Trames vides de fin déjà nulles
+                    ring.publishSlot();
+                }
+            } catch (const std::exception& e) {
+                readerError = e.what();
+            }
+            ring.close();
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        unsigned long sent = 0;
+        try {
+            while (const uint8_t* frames = ring.front()) {
+                manager.programFrames(frames);
+                ring.releaseFront();
+                ++sent;
+            }
+        } catch (...) {
+            ring.close();
+            reader.join();
+            throw;
+        }
+        reader.join();
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << sent << " vecteurs envoyés en " << seconds << " s";
+        if (seconds > 0.0) {
+            std::cout << ", " << sent / seconds << " mises à jour/s";
+        }
+        std::cout << " (lecteur bloqué " << ring.producerStalls() << " fois, envoi en attente "
+                  << ring.consumerStalls() << " fois)\n";
+        if (!readerError.empty()) {
+            std::cerr << readerError << "\n";
+            return 1;
+        }
+    } else if (command == "--set-verify") {
+        if (argc < 3) {
+            std::cerr << "Erreur : aucune valeur fournie pour --set-verify\n";
+            return 1;
+        }
+        auto mismatches = manager.programAndVerify(parseValues(argc, argv, 2));
+        for (size_t i = 0; i < mismatches.size(); ++i) {
+            if (mismatches[i]) {
+                std::cout << "Potentiomètre #" << i + 1 << ": valeur relue différente de la consigne\n";
+            }
+        }
+        if (mismatches.any()) {
+            return 2;
+        }
+    } else if (command == "--plan") {
+        OperationPlan plan = buildPlan(argc, argv, 2);
+        plan.print(std::cout, manager.costModel());
+        auto mismatches = plan.transfers().empty() ? std::bitset<NUM_POTS>() : manager.executePlan(plan);
+        for (size_t i = 0; i < mismatches.size(); ++i) {
+            if (mismatches[i]) {
+                std::cout << "Potentiomètre #" << i + 1 << ": valeur relue différente de la consigne\n";
+            }
+        }
+        if (mismatches.any()) {
+            return 2;
+        }
+    } else if (command == "--store") {
+        auto stored = manager.storeResistancesToMemory();
+        for (size_t i = 0; i < stored.size(); ++i) {
+            std::cout << "Potentiomètre #" << i + 1 << ": "
+                      << (stored[i] ? "stocké en mémoire" : "inchangé, stockage ignoré") << "\n";
+        }
+    } else if (command == "--wear") {
+        auto used = manager.otpSlotsUsed();
+        for (size_t i = 0; i < used.size(); ++i) {
+            std::cout << "Potentiomètre #" << i + 1 << ": " << used[i] << "/" << OTP_SLOT_COUNT
+                      << " emplacements utilisés\n";
+        }
+    } else if (command == "--preset-apply") {
+        if (argc < 4) {
+            std::cerr << "Erreur : usage --preset-apply <fichier> <nom>\n";
+            return 1;
+        }
+        PresetBank bank;
+        bank.load(argv[2]);
+        int index = bank.findPreset(argv[3]);
+        if (index < 0) {
+            std::cerr << "Erreur : préréglage \"" << argv[3] << "\" introuvable\n";
+            return 1;
+        }
+        manager.applyPreset(bank, index);
+    } else if (command == "--fade") {
+        if (argc < 5) {
+            std::cerr << "Erreur : usage --fade <ms> <lin|log> [values...]\n";
+            return 1;
+        }
+        std::string taper = argv[3];
+        if (taper != "lin" && taper != "log") {
+            std::cerr << "Erreur : courbe inconnue \"" << taper << "\" (lin ou log)\n";
+            return 1;
+        }
+        StreamStats stats = manager.crossfade(parseValues(argc, argv, 4),
+                                              std::chrono::milliseconds(std::stoi(argv[2])),
+                                              taper == "log" ? TaperMode::Logarithmic : TaperMode::Linear);
+        std::cout << "Trames envoyées : " << stats.framesDelivered
+                  << " (" << stats.framesLate << " en retard) en " << stats.elapsedSeconds << " s, "
+                  << stats.updatesPerSecond << " mises à jour/s\n";
+    } else if (command == "--trigger") {
+        if (argc < 5) {
+            std::cerr << "Erreur : usage --trigger <n> <timeout_ms> [values...]\n";
+            return 1;
+        }
+        int count = std::stoi(argv[2]);
+        std::chrono::milliseconds timeout(std::stoi(argv[3]));
+        std::vector<uint16_t> values = parseValues(argc, argv, 4);
+
+        manager.configureTriggerPin();
+        LatencyRecorder latencies;
+        for (int i = 0; i < count; ++i) {
+            TriggerResult result = manager.programOnTrigger(values, timeout);
+            if (!result.fired) {
+                std::cerr << "Aucun déclenchement avant l'expiration du délai\n";
+                break;
+            }
+            latencies.add(result.latencyMicros);
+        }
+        if (latencies.count() > 0) {
+            std::cout << "Latence déclenchement -> mise à jour (us) sur " << latencies.count() << " fronts : "
+                      << "min " << latencies.min() << ", p50 " << latencies.percentile(50)
+                      << ", p90 " << latencies.percentile(90) << ", p99 " << latencies.percentile(99)
+                      << ", max " << latencies.max() << "\n";
+        }
+    } else if (command == "--gpio-read") {
+        std::cout << "GPIO : 0x" << std::hex << manager.gpio().readPins() << std::dec << "\n";
+    } else if (command == "--gpio-set") {
+        if (argc < 4) {
+            std::cerr << "Erreur : usage --gpio-set <masque> <valeurs>\n";
+            return 1;
+        }
+        manager.gpio().setPins(static_cast<uint16_t>(std::stoul(argv[2], nullptr, 0)),
+                               static_cast<uint16_t>(std::stoul(argv[3], nullptr, 0)));
+        manager.gpio().flush();
+    } else if (command == "--gpio-toggle") {
+        if (argc < 3) {
+            std::cerr << "Erreur : usage --gpio-toggle <masque>\n";
+            return 1;
+        }
+        manager.gpio().togglePins(static_cast<uint16_t>(std::stoul(argv[2], nullptr, 0)));
+        manager.gpio().flush();
+    } else if (command == "--chains") {
+        if (argc < 3) {
+            std::cerr << "Erreur : usage --chains <cs>[@famille,...]:<v1,v2,...> [...]\n";
+            return 1;
+        }
+        // Chaque commande décrit l'ensemble des chaînes : une ligne de script précédente ne s'y ajoute pas
+        ChainSet& chains = manager.chains();
+        chains.clear();
+        for (int i = 2; i < argc; ++i) {
+            std::string spec = argv[i];
+            size_t colon = spec.find(':');
+            if (colon == std::string::npos) {
+                std::cerr << "Erreur : chaîne mal formée \"" << spec << "\"\n";
+                return 1;
+            }
+            std::vector<uint16_t> values;
+            for (size_t pos = colon + 1; pos <= spec.size();) {
+                size_t comma = spec.find(',', pos);
+                if (comma == std::string::npos) comma = spec.size();
+                values.push_back(static_cast<uint16_t>(std::stoi(spec.substr(pos, comma - pos))));
+                pos = comma + 1;
+            }
+            // Familles optionnelles après '@', une par position ; la dernière s'applique aux positions restantes
+            std::string csSpec = spec.substr(0, colon);
+            size_t at = csSpec.find('@');
+            std::vector<PotFamily> parts;
+            if (at != std::string::npos) {
+                for (size_t pos = at + 1; pos <= csSpec.size();) {
+                    size_t comma = csSpec.find(',', pos);
+                    if (comma == std::string::npos) comma = csSpec.size();
+                    parts.push_back(parsePotFamily(csSpec.substr(pos, comma - pos)));
+                    pos = comma + 1;
+                }
+                parts.resize(values.size(), parts.back());
+            } else {
+                parts.assign(values.size(), PotFamily::AD5270);
+            }
+            size_t chain = chains.addChain(static_cast<uint16_t>(std::stoul(csSpec.substr(0, at), nullptr, 0)), ChainLayout(parts));
+            chains.stage(chain, values);
+        }
+        chains.commit();
+        ChainSetStats stats = chains.stats();
+        std::cout << stats.updates << " chaînes programmées, " << stats.settingsWrites << " changements de CS ("
+                  << stats.settingsSkipped << " évités), " << stats.updatesPerSecond << " mises à jour/s\n";
+    } else if (command == "--monitor") {
+        if (argc < 3) {
+            std::cerr << "Erreur : usage --monitor <s>\n";
+            return 1;
+        }
+        HealthMonitor monitor(manager, std::chrono::milliseconds(500));
+        monitor.start();
+        std::this_thread::sleep_for(std::chrono::seconds(std::stoi(argv[2])));
+        monitor.stop();
+
+        LatencyRecorder downtimes = monitor.downtimes();
+        std::cout << monitor.recoveries() << " reconnexions";
+        if (downtimes.count() > 0) {
+            std::cout << ", interruption moyenne " << downtimes.mean() / 1000.0 << " ms, max "
+                      << downtimes.max() / 1000.0 << " ms";
+        }
+        std::cout << "\n";
+    } else if (command == "--sched-check") {
+        if (argc < 4) {
+            std::cerr << "Erreur : usage --sched-check <n> [values...]\n";
+            return 1;
+        }
+        int count = std::stoi(argv[2]);
+        std::vector<uint16_t> values = parseValues(argc, argv, 3);
+        CommandScheduler scheduler;
+
+        // Dump EEPROM de 256 octets en tâche de fond, un rapport par étape
+        std::vector<uint8_t> eeprom(256);
+        size_t address = 0;
+        scheduler.submit(Lane::Bulk, std::chrono::seconds(10), [&]() {
+            eeprom[address] = manager.readEeprom(static_cast<uint8_t>(address));
+            return ++address == eeprom.size();
+        });
+        scheduler.submitOnce(Lane::Bulk, std::chrono::seconds(10), [&]() { manager.chipStatus(); });
+
+        for (int i = 0; i < count; ++i) {
+            scheduler.submitOnce(Lane::RealTime, std::chrono::milliseconds(5), [&]() { manager.programResistances(values); });
+            scheduler.submitOnce(Lane::Interactive, std::chrono::milliseconds(20), [&]() { manager.refreshCurrentResistances(); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        scheduler.drain();
+
+        const char* names[LANE_COUNT] = {"temps réel", "interactif", "fond"};
+        for (size_t lane = 0; lane < LANE_COUNT; ++lane) {
+            LaneStats stats = scheduler.stats(static_cast<Lane>(lane));
+            std::cout << "File " << names[lane] << " : " << stats.completed << " travaux, " << stats.steps
+                      << " étapes, " << stats.deadlineMisses << " échéances manquées, latence p50 "
+                      << stats.latency.percentile(50) << " us, p99 " << stats.latency.percentile(99) << " us\n";
+        }
+    } else if (command == "--bench") {
+        unsigned int iterations = 200;
+        std::vector<unsigned int> bitRates = {1000000, 3000000, 12000000};
+        std::vector<size_t> lengths = {1, 2, 5, 10, 20, 30};
+        std::string jsonPath;
+        auto parseList = [](const std::string& list) {
+            std::vector<unsigned long> items;
+            std::istringstream stream(list);
+            for (std::string item; std::getline(stream, item, ',');) {
+                items.push_back(std::stoul(item));
+            }
+            return items;
+        };
+        for (int i = 2; i < argc; ++i) {
+            std::string option = argv[i];
+            if (option == "--bitrates" && i + 1 < argc) {
+                bitRates.clear();
+                for (unsigned long rate : parseList(argv[++i])) bitRates.push_back(static_cast<unsigned int>(rate));
+            } else if (option == "--lengths" && i + 1 < argc) {
+                lengths.clear();
+                for (unsigned long length : parseList(argv[++i])) lengths.push_back(length);
+            } else if (option == "--json" && i + 1 < argc) {
+                jsonPath = argv[++i];
+            } else {
+                iterations = static_cast<unsigned int>(std::stoul(option));
+            }
+        }
+
+        Benchmark benchmark(manager, iterations);
+        benchmark.run(bitRates, lengths);
+        benchmark.printSummary(jsonPath == "-" ? std::cerr : std::cout);
+
+        std::string target = manager.serialNumber() == "SIMULATEUR" ? "simulateur" : "materiel";
+        if (jsonPath == "-") {
+            benchmark.writeJson(std::cout, target);
+        } else if (!jsonPath.empty()) {
+            std::ofstream json(jsonPath);
+            benchmark.writeJson(json, target);
+            if (!json) {
+                std::cerr << "Erreur : écriture de \"" << jsonPath << "\" impossible\n";
+                return 1;
+            }
+        }
+    } else if (command == "--estimate") {
+        unsigned int samples = argc >= 3 ? static_cast<unsigned int>(std::stoi(argv[2])) : 10;
+        std::cout << "Aller-retour USB mesuré : " << manager.measureRoundTrip(samples) << " us\n";
+
+        const std::pair<ChainOperation, const char*> operations[] = {
+            {ChainOperation::Read, "lecture RDAC"},
+            {ChainOperation::ReadMemory, "lecture mémoire"},
+            {ChainOperation::Program, "programmation"},
+            {ChainOperation::ProgramAndVerify, "programmation + vérification"},
+            {ChainOperation::Preset, "préréglage"},
+            {ChainOperation::Store, "stockage 50-TP"},
+        };
+        for (const auto& operation : operations) {
+            CostEstimate estimate = manager.estimate(operation.first);
+            std::cout << operation.second << " : " << estimate.transfers << " transferts, " << estimate.reports
+                      << " rapports USB, SPI " << estimate.spiMicros << " us, total " << estimate.totalMicros << " us\n";
+        }
+    } else if (command == "--help") {
+        printHelp();
+    } else {
+        std::cerr << "Erreur : commande inconnue \"" << command << "\"\n";
+        printHelp();
+        return 1;
+    }
+    return 0;
+}
+
+// Écritures différées d'un script : les commandes set/set-one et GPIO consécutives partent en un seul transfert
+struct ScriptState {
+    std::vector<uint16_t> pendingValues;
+    size_t pendingCommands;
+    bool gpioPending;
+    std::vector<uint16_t> expected; // Dernières valeurs programmées, référence de verify
+    CommandScheduler* scheduler;    // Accès à l'adaptateur, devant la surveillance en tâche de fond
+};
+
+#define SCRIPT_WRITE_DEADLINE std::chrono::milliseconds(5)
+#define SCRIPT_COMMAND_DEADLINE std::chrono::milliseconds(20)
+
+// Les écritures passent par la file temps réel, les autres commandes par la file interactive
+void runScheduled(ScriptState& state, Lane lane, std::chrono::microseconds deadline, std::function<void()> action) {
+    state.scheduler->submitOnce(lane, deadline, std::move(action)).get();
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Barrière : envoie les écritures différées avant toute commande qui lit, attend ou stocke
+void flushPending(PotentiometerManager& manager, ScriptState& state) {
+    auto start = std::chrono::steady_clock::now();
+    if (state.pendingCommands > 0) {
+        runScheduled(state, Lane::RealTime, SCRIPT_WRITE_DEADLINE, [&]() { manager.programResistances(state.pendingValues); });
+        state.expected = state.pendingValues;
+        std::cout << "  écriture groupée (" << state.pendingCommands << " commandes) : " << elapsedMs(start) << " ms\n";
+        state.pendingCommands = 0;
+    }
+    if (state.gpioPending) {
+        runScheduled(state, Lane::RealTime, SCRIPT_WRITE_DEADLINE, [&]() { manager.gpio().flush(); });
+        state.gpioPending = false;
+    }
+}
+
+std::vector<uint16_t> parseWords(const std::vector<std::string>& words, size_t first) {
+    std::vector<uint16_t> values;
+    for (size_t i = first; i < words.size(); ++i) {
+        values.push_back(static_cast<uint16_t>(std::stoi(words[i])));
+    }
+    return values;
+}
+
+// Exécute une commande de script ; retourne un code de sortie (2 : vérification en échec)
+int runScriptCommand(PotentiometerManager& manager, ScriptState& state, std::vector<std::string> words, char* program) {
+    std::string name = words[0];
+    auto start = std::chrono::steady_clock::now();
+
+    if (name == "set" || name == "set-one") {
+        std::vector<uint16_t> values;
+        if (name == "set") {
+            values = parseWords(words, 1);
+            if (values.size() != NUM_POTS) {
+                throw std::runtime_error("le nombre de valeurs ne correspond pas au nombre de potentiomètres.");
+            }
+        } else {
+            if (words.size() != 3) {
+                throw std::runtime_error("usage set-one <potentiomètre> <valeur>");
+            }
+            size_t pot = std::stoul(words[1]);
+            if (pot < 1 || pot > NUM_POTS) {
+                throw std::runtime_error("numéro de potentiomètre invalide.");
+            }
+            if (state.pendingCommands > 0) {
+                values = state.pendingValues;
+            } else if (!state.expected.empty()) {
+                values = state.expected;
+            } else {
+                runScheduled(state, Lane::Interactive, SCRIPT_COMMAND_DEADLINE, [&]() { values = manager.refreshCurrentResistances(); });
+            }
+            values[pot - 1] = static_cast<uint16_t>(std::stoi(words[2]));
+        }
+        state.pendingValues = values;
+        ++state.pendingCommands;
+        std::cout << name << " : différé\n";
+        return 0;
+    }
+    if (name == "gpio-set" || name == "gpio-toggle") {
+        if (name == "gpio-set" && words.size() == 3) {
+            manager.gpio().setPins(static_cast<uint16_t>(std::stoul(words[1], nullptr, 0)),
+                                   static_cast<uint16_t>(std::stoul(words[2], nullptr, 0)));
+        } else if (name == "gpio-toggle" && words.size() == 2) {
+            manager.gpio().togglePins(static_cast<uint16_t>(std::stoul(words[1], nullptr, 0)));
+        } else {
+            throw std::runtime_error("usage " + name + (name == "gpio-set" ? " <masque> <valeurs>" : " <masque>"));
+        }
+        state.gpioPending = true;
+        std::cout << name << " : différé\n";
+        return 0;
+    }
+
+    flushPending(manager, state);
+    start = std::chrono::steady_clock::now();
+    int status = 0;
+
+    if (name == "sleep") {
+        if (words.size() != 2) {
+            throw std::runtime_error("usage sleep <ms>");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::stoi(words[1])));
+    } else if (name == "verify") {
+        std::vector<uint16_t> target = words.size() > 1 ? parseWords(words, 1) : state.expected;
+        if (target.size() != NUM_POTS) {
+            throw std::runtime_error("aucune consigne à vérifier.");
+        }
+        std::vector<uint16_t> values;
+        runScheduled(state, Lane::Interactive, SCRIPT_COMMAND_DEADLINE, [&]() { values = manager.refreshCurrentResistances(); });
+        for (int i = 0; i < NUM_POTS; ++i) {
+            if ((values[i] & RDAC_VALUE_MASK) != (target[i] & RDAC_VALUE_MASK)) {
+                std::cout << "Potentiomètre #" << i + 1 << ": " << values[i] << " relu, " << target[i] << " attendu\n";
+                status = 2;
+            }
+        }
+    } else if (name == "script" || name == "repl" || name == "--script" || name == "--repl") {
+        throw std::runtime_error("scripts imbriqués non pris en charge.");
+    } else {
+        // Autres commandes : mêmes noms que la ligne de commande, avec ou sans "--"
+        if (name == "read") words[0] = "read-current";
+        if (words[0].compare(0, 2, "--") != 0) words[0] = "--" + words[0];
+
+        std::vector<char*> args;
+        args.push_back(program);
+        for (std::string& word : words) {
+            args.push_back(&word[0]);
+        }
+        runScheduled(state, Lane::Interactive, SCRIPT_COMMAND_DEADLINE, [&]() {
+            status = runCommand(manager, static_cast<int>(args.size()), args.data());
+        });
+        if (status == 0 && (words[0] == "--set" || words[0] == "--set-verify")) {
+            state.expected = parseWords(words, 1);
+        }
+    }
+
+    std::cout << name << " : " << elapsedMs(start) << " ms\n";
+    return status;
+}
+
+// --script <fichier|-> ou --repl : un seul gestionnaire pour une suite de commandes, séparées par ';' ou par ligne.
+// En script, les écritures consécutives sont regroupées jusqu'à la prochaine barrière ; en mode interactif,
+// elles partent à la fin de chaque ligne et l'adaptateur est surveillé entre les commandes.
+int runScript(PotentiometerManager& manager, int argc, char* argv[]) {
+    bool interactive = std::string(argv[1]) == "--repl";
+    std::ifstream file;
+    if (!interactive) {
+        if (argc < 3) {
+            std::cerr << "Erreur : usage --script <fichier|->\n";
+            return 1;
+        }
+        if (std::string(argv[2]) != "-") {
+            file.open(argv[2]);
+            if (!file) {
+                std::cerr << "Erreur : impossible d'ouvrir le script \"" << argv[2] << "\"\n";
+                return 1;
+            }
+        }
+    }
+    std::istream& input = file.is_open() ? static_cast<std::istream&>(file) : std::cin;
+
+    // Ordonnanceur déclaré avant la surveillance : il doit lui survivre
+    CommandScheduler scheduler;
+    HealthMonitor monitor(manager, std::chrono::milliseconds(500), &scheduler);
+    if (interactive) {
+        monitor.start();
+    }
+
+    ScriptState state = {std::vector<uint16_t>(), 0, false, std::vector<uint16_t>(), &scheduler};
+    auto scriptStart = std::chrono::steady_clock::now();
+    size_t commands = 0;
+    size_t lineNumber = 0;
+    int status = 0;
+    std::string line;
+
+    while (true) {
+        if (interactive) {
+            std::cout << "mcp2210> " << std::flush;
+        }
+        if (!std::getline(input, line)) {
+            break;
+        }
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+
+        try {
+            bool quit = false;
+            std::istringstream statements(line);
+            std::string statement;
+            while (std::getline(statements, statement, ';')) {
+                std::istringstream wordStream(statement);
+                std::vector<std::string> words;
+                for (std::string word; wordStream >> word;) {
+                    words.push_back(word);
+                }
+                if (words.empty()) continue;
+                if (words[0] == "quit" || words[0] == "exit") {
+                    quit = true;
+                    break;
+                }
+
+                ++commands;
+                int commandStatus = runScriptCommand(manager, state, words, argv[0]);
+                if (commandStatus != 0) {
+                    if (!interactive) {
+                        std::cerr << "Erreur ligne " << lineNumber << " : commande \"" << words[0] << "\" en échec\n";
+                        return commandStatus;
+                    }
+                    status = commandStatus;
+                }
+            }
+            if (interactive || quit) {
+                flushPending(manager, state);
+            }
+            if (quit) {
+                break;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Erreur ligne " << lineNumber << " : " << e.what() << "\n";
+            if (!interactive) {
+                return 1;
+            }
+            state.pendingCommands = 0;
+            state.gpioPending = false;
+        }
+    }
+
+    flushPending(manager, state);
+    std::cout << commands << " commandes en " << elapsedMs(scriptStart) << " ms\n";
+    LaneStats writes = scheduler.stats(Lane::RealTime);
+    if (writes.completed > 0) {
+        std::cout << writes.completed << " écritures, " << writes.deadlineMisses << " échéances manquées, latence p99 "
+                  << writes.latency.percentile(99) << " us\n";
+    }
+    return status;
+}
+
+// Enregistrement ou rejeu des rapports USB : installé comme transport par défaut
+// avant l'ouverture, détruit après le gestionnaire
+struct ReportCapture {
+    hid_device* hardware = nullptr;
+    std::unique_ptr<HidapiTransport> hardwareTransport;
+    std::unique_ptr<RecordingTransport<HidapiTransport>> hardwareRecorder;
+    std::unique_ptr<RecordingTransport<LoopbackTransport>> simulatorRecorder;
+    std::unique_ptr<ReplayTransport> replay;
+
+    ~ReportCapture() {
+        if (hardwareRecorder || simulatorRecorder || replay) {
+            SetMCP2210DefaultTransport(NULL, NULL);
+        }
+        if (hardware) {
+            ReleaseMCP2210(hardware);
+        }
+    }
+};
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         printHelp();
         return 1;
     }
 
+    // Options globales placées avant la commande ; argv est décalé pour que la commande reste en argv[1]
+    long lockTimeoutMs = -1;
+    bool externalMaster = false;
+    bool publishState = false;
+    bool simulate = false;
+    long simulatedLatencyUs = 0;
+    std::string metricsListen;
+    std::string metricsFile;
+    long metricsPeriodS = 15;
+    long spiTimeoutMs = -1;
+    long spiMaxPolls = -1;
+    std::string pathCacheFile;
+    std::string recordFile;
+    std::string replayFile;
+    while (argc >= 2) {
+        std::string option = argv[1];
+        int consumed = 0;
+        if (option == "--lock" && argc >= 3) {
+            lockTimeoutMs = std::stol(argv[2]);
+            consumed = 2;
+        } else if (option == "--external-master") {
+            externalMaster = true;
+            consumed = 1;
+        } else if (option == "--publish-state") {
+            publishState = true;
+            consumed = 1;
+        } else if (option == "--simulate") {
+            simulate = true;
+            consumed = 1;
+            if (argc >= 3 && std::isdigit(static_cast<unsigned char>(argv[2][0]))) {
+                simulatedLatencyUs = std::stol(argv[2]);
+                consumed = 2;
+            }
+        } else if (option == "--spi-timeout" && argc >= 3) {
+            spiTimeoutMs = std::stol(argv[2]);
+            consumed = 2;
+            if (argc >= 4 && std::isdigit(static_cast<unsigned char>(argv[3][0]))) {
+                spiMaxPolls = std::stol(argv[3]);
+                consumed = 3;
+            }
+        } else if (option == "--fast-open") {
+            pathCacheFile = DEVICE_PATH_CACHE_FILE;
+            consumed = 1;
+            if (argc >= 3 && argv[2][0] != '-') {
+                pathCacheFile = argv[2];
+                consumed = 2;
+            }
+        } else if (option == "--record" && argc >= 3) {
+            recordFile = argv[2];
+            consumed = 2;
+        } else if (option == "--replay" && argc >= 3) {
+            replayFile = argv[2];
+            consumed = 2;
+        } else if (option == "--metrics-listen" && argc >= 3) {
+            metricsListen = argv[2];
+            consumed = 2;
+        } else if (option == "--metrics-file" && argc >= 3) {
+            metricsFile = argv[2];
+            consumed = 2;
+            if (argc >= 4 && std::isdigit(static_cast<unsigned char>(argv[3][0]))) {
+                metricsPeriodS = std::max(1L, std::stol(argv[3]));
+                consumed = 3;
+            }
+        } else {
+            break;
+        }
+        argv[consumed] = argv[0];
+        argv += consumed;
+        argc -= consumed;
+    }
+    if (argc < 2) {
+        printHelp();
+        return 1;
+    }
+
     std::string command = argv[1];
-    PotentiometerManager manager;
+    if (command == "--preset-save") {
+        return savePreset(argc, argv);
+    }
+    if (command == "--snapshot") {
+        return showSnapshot(argc, argv);
+    }
+    if (command == "--plan" && argc >= 3 && std::string(argv[2]) == "--dry-run") {
+        // Simulation : aucun accès à l'adaptateur, coût selon le modèle par défaut
+        try {
+            buildPlan(argc, argv, 3).print(std::cout, TransferCostModel());
+        } catch (const std::exception& e) {
+            std::cerr << "Erreur : " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // Le simulateur doit être installé avant l'ouverture et survivre au gestionnaire
+    std::unique_ptr<MCP2210Simulator> simulator;
+    if (simulate) {
+        simulator.reset(new MCP2210Simulator(NUM_POTS, std::chrono::microseconds(simulatedLatencyUs)));
+        simulator->install();
+    }
 
+    ReportCapture capture;
     try {
-        if (command == "--read-current") {
-            auto resistances = manager.readCurrentResistances();
-            for (size_t i = 0; i < resistances.size(); ++i) {
-                std::cout << "Potentiomètre #" << i + 1 << ": " << resistances[i] << " ohms\n";
-            }
-        } else if (command == "--read-memory") {
-            auto resistances = manager.readMemoryResistances();
-            for (size_t i = 0; i < resistances.size(); ++i) {
-                std::cout << "Potentiomètre #" << i + 1 << ": " << resistances[i] << " ohms\n";
-            }
-        } else if (command == "--set") {
-            if (argc < 3) {
-                std::cerr << "Erreur : aucune valeur fournie pour --set\n";
-                return 1;
+        if (!replayFile.empty()) {
+            if (simulate || !recordFile.empty()) {
+                throw std::runtime_error("Erreur : --replay exclut --simulate et --record.");
             }
-            std::vector<uint16_t> values;
-            for (int i = 2; i < argc; ++i) {
-                values.push_back(static_cast<uint16_t>(std::stoi(argv[i])));
-            }
-            manager.programResistances(values);
-        } else if (command == "--store") {
-            manager.storeResistancesToMemory();
-        } else if (command == "--help") {
-            printHelp();
-        } else {
-            std::cerr << "Erreur : commande inconnue \"" << command << "\"\n";
-            printHelp();
+            capture.replay.reset(new ReplayTransport(replayFile));
+            InstallMCP2210Transport(*capture.replay);
+        } else if (!recordFile.empty() && simulator) {
+            capture.simulatorRecorder.reset(new RecordingTransport<LoopbackTransport>(simulator->transport(), recordFile));
+            InstallMCP2210Transport(*capture.simulatorRecorder);
+        } else if (!recordFile.empty()) {
+            capture.hardware = InitMCP2210();
+            if (!capture.hardware) {
+                throw std::runtime_error("Impossible d'initialiser le MCP2210.");
+            }
+            capture.hardwareTransport.reset(new HidapiTransport(capture.hardware));
+            capture.hardwareRecorder.reset(new RecordingTransport<HidapiTransport>(*capture.hardwareTransport, recordFile));
+            InstallMCP2210Transport(*capture.hardwareRecorder);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    // Exportateur créé avant le gestionnaire : l'ouverture de l'adaptateur est comptée,
+    // et détruit après lui pour que le dernier fichier contienne toute la session
+    std::unique_ptr<MetricsExporter> metricsExporter;
+    if (!metricsListen.empty() || !metricsFile.empty()) {
+        try {
+            Metrics::global().observeCommands();
+            metricsExporter.reset(new MetricsExporter(Metrics::global(), metricsListen, metricsFile,
+                                                      std::chrono::seconds(metricsPeriodS)));
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        if (!metricsListen.empty()) {
+            std::cerr << "Métriques : " << metricsExporter->endpoint() << "\n";
+        }
+    }
+
+    if (spiTimeoutMs == 0 && spiMaxPolls == 0) {
+        std::cerr << "Erreur : --spi-timeout 0 exige un nombre maximal de sondages non nul\n";
+        return 1;
+    }
+
+    PotentiometerManager manager(pathCacheFile);
+    if (spiTimeoutMs >= 0) {
+        SPITransferPolicyDef policy = manager.transferPolicy();
+        policy.TimeoutMicros = static_cast<unsigned int>(spiTimeoutMs * 1000);
+        if (spiMaxPolls >= 0) {
+            policy.MaxPolls = static_cast<unsigned int>(spiMaxPolls);
+        }
+        manager.setTransferPolicy(policy);
+    }
+    if (lockTimeoutMs >= 0 || externalMaster) {
+        manager.enableArbitration(std::chrono::milliseconds(lockTimeoutMs >= 0 ? lockTimeoutMs : 1000), externalMaster);
+    }
+
+    try {
+        if (publishState) {
+            manager.enableStatePublishing();
+        }
+
+        int status = (command == "--script" || command == "--repl")
+            ? runScript(manager, argc, argv)
+            : runCommand(manager, argc, argv);
+        if (status != 0) {
+            return status;
         }
     } catch (const std::exception& e) {
         std::cerr << "Erreur : " << e.what() << "\n";
         return 1;
     }
 
+    if (capture.replay && !capture.replay->finished()) {
+        std::cerr << "Rejeu : " << capture.replay->position() << " rapports rejoués, fin de l'enregistrement non atteinte\n";
+    }
+
+    if (!pathCacheFile.empty()) {
+        OpenTiming timing = manager.openTiming();
+        std::cerr << "Ouverture : " << (timing.cachedPath ? "chemin mémorisé " : "énumération ")
+                  << (timing.devicePath.empty() ? "-" : timing.devicePath) << " en " << timing.openMicros / 1000.0 << " ms";
+        if (timing.firstTransferMicros >= 0) {
+            std::cerr << ", premier transfert à " << timing.firstTransferMicros / 1000.0 << " ms";
+        }
+        std::cerr << "\n";
+    }
+
+    if (const AdapterLock* lock = manager.arbitration()) {
+        std::cerr << "Verrou : " << lock->holdTimes().count() << " transactions, attente p99 "
+                  << lock->waitTimes().percentile(99) << " us, détention p99 " << lock->holdTimes().percentile(99)
+                  << " us, max " << lock->holdTimes().max() << " us\n";
+    }
+
     return 0;
 }
\ No newline at end of file
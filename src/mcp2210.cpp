@@ -16,8 +16,6 @@
  *  limitations under the License.
  */
 
-using namespace std;
-
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -28,40 +26,108 @@ using namespace std;
 #include <synchapi.h>
 #endif
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+#endif
+
+#include <chrono>
+#include <thread>
+
 #include "mcp2210.h"
+#include "MCP2210Transport.h"
+
+struct TransportSlot {
+    const MCP2210TransportOps *ops;
+    void *transport;
+};
+
+// The address of a slot is the handle of its transport; slot 0 is the default one
+static TransportSlot transportSlots[MCP2210_MAX_TRANSPORTS];
+static LoopbackTransport virtualLoopback;
+static MCP2210CommandObserver commandObserver = NULL;
+static void *commandObserverContext = NULL;
+
+static TransportSlot* TransportSlotOf(hid_device *handle) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(handle);
+    uintptr_t first = reinterpret_cast<uintptr_t>(&transportSlots[0]);
+    uintptr_t last = reinterpret_cast<uintptr_t>(&transportSlots[MCP2210_MAX_TRANSPORTS - 1]);
+    if (address < first || address > last) return NULL;
+    return reinterpret_cast<TransportSlot*>(handle);
+}
 
-int SendUSBCmd(hid_device *handle, byte *cmdBuf, byte *responseBuf) {
-    int r = 0;
-    r = hid_write(handle, cmdBuf, 64);
-    if (r < 0) return ERROR_UNABLE_TO_WRITE_TO_DEVICE;
-
-    //when the hid device is configured as synchronous, the first 
-    //hid_read returns the desired results. and the while() loop
-    //is skipped.
-    //
-    //when the hid device is configured as asynchronous, the first
-    //hid_read may or may not succeed, depending on the latency
-    //of the attached device. When no data is returned, r = 0 and
-    //the while loop keeps polling the returned data until it is 
-    //received.
-
-    r = 0;
-    r = hid_read(handle, responseBuf, 64);
-    if (r < 0) return ERROR_UNABLE_TO_READ_FROM_DEVICE;
-
-    while (r == 0) {
-        r = hid_read(handle, responseBuf, 64);
-        if (r < 0) return ERROR_UNABLE_TO_READ_FROM_DEVICE;
-
-        #ifdef _WIN32
-            Sleep(1); // Sleep (millisecondes) sous Windows
-        //#else
-            //usleep(1000); // Usleep (microsecondes) sous Linux
-        #endif
+static hid_device* DefaultTransportHandle() {
+    return reinterpret_cast<hid_device*>(&transportSlots[0]);
+}
 
+void SetMCP2210VirtualDevice(MCP2210VirtualHandler handler, void *context) {
+    if (!handler) {
+        SetMCP2210DefaultTransport(NULL, NULL);
+        return;
     }
+    virtualLoopback.setResponder(handler, context);
+    InstallMCP2210Transport(virtualLoopback);
+}
+
+bool IsMCP2210VirtualDevice(hid_device *handle) {
+    return TransportSlotOf(handle) != NULL;
+}
 
-    return responseBuf[1];
+hid_device* BindMCP2210Transport(const MCP2210TransportOps *ops, void *transport) {
+    for (int i = 1; i < MCP2210_MAX_TRANSPORTS; i++) {
+        if (transportSlots[i].ops) continue;
+        transportSlots[i].ops = ops;
+        transportSlots[i].transport = transport;
+        return reinterpret_cast<hid_device*>(&transportSlots[i]);
+    }
+    return NULL;
+}
+
+void SetMCP2210DefaultTransport(const MCP2210TransportOps *ops, void *transport) {
+    transportSlots[0].ops = ops;
+    transportSlots[0].transport = ops ? transport : NULL;
+}
+
+void UnbindMCP2210Transport(hid_device *handle) {
+    TransportSlot *slot = TransportSlotOf(handle);
+    if (!slot) return;
+    slot->ops = NULL;
+    slot->transport = NULL;
+}
+
+int GetMCP2210TransportFd(hid_device *handle) {
+    TransportSlot *slot = TransportSlotOf(handle);
+    if (!slot || !slot->ops) return -1;
+    return slot->ops->fd(slot->transport);
+}
+
+void SetMCP2210CommandObserver(MCP2210CommandObserver observer, void *context) {
+    commandObserver = observer;
+    commandObserverContext = context;
+}
+
+static int ExchangeUSBReports(hid_device *handle, byte *cmdBuf, byte *responseBuf) {
+    TransportSlot *slot = TransportSlotOf(handle);
+    if (slot) {
+        if (!slot->ops) return ERROR_INVALID_DEVICE_HANDLE;
+        return slot->ops->exchange(slot->transport, cmdBuf, responseBuf);
+    }
+
+    // USB devices: the hidapi transport is resolved at compile time
+    HidapiTransport transport(handle);
+    return ExchangeReports(transport, cmdBuf, responseBuf);
+}
+
+int SendUSBCmd(hid_device *handle, byte *cmdBuf, byte *responseBuf) {
+    if (!commandObserver) return ExchangeUSBReports(handle, cmdBuf, responseBuf);
+
+    // Only timed when observed: the clock reads stay off the plain path
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int r = ExchangeUSBReports(handle, cmdBuf, responseBuf);
+    double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    commandObserver(commandObserverContext, cmdBuf, responseBuf, r, micros);
+    return r;
 }
 
 SPITransferSettingsDef GetSPITransferSettings(hid_device *handle, bool isVolatile) {
@@ -434,6 +500,8 @@ ChipStatusDef CancelSPITransfer(hid_device *handle) {
 
 SPIDataTransferStatusDef SPIDataTransfer(hid_device *handle, byte* data, int length) {
     SPIDataTransferStatusDef def;
+    def.NumberOfBytesReceived = 0;
+    def.SPIEngineStatus = 0;
 
     byte cmd[COMMAND_BUFFER_LENGTH];
     byte rsp[RESPONSE_BUFFER_LENGTH];
@@ -462,16 +530,93 @@ SPIDataTransferStatusDef SPIDataTransfer(hid_device *handle, byte* data, int len
 }
 
 SPIDataTransferStatusDef SPISendReceive(hid_device *handle, byte* data, int cmdBufferLength, int dataLength) {
-    SPIDataTransferStatusDef def = SPIDataTransfer(handle, data, cmdBufferLength);
+    return SPISendReceiveBounded(handle, data, cmdBufferLength, dataLength, DefaultSPITransferPolicy()).Status;
+}
 
-    while (def.SPIEngineStatus == SPI_STATUS_STARTED_NO_DATA_TO_RECEIVE || def.SPIEngineStatus == SPI_STATUS_SUCCESSFUL) {
-        if (dataLength > 0)
-            def = SPIDataTransfer(handle, data, dataLength);
-        else
-            def = SPIDataTransfer(handle, data, cmdBufferLength);
+SPITransferPolicyDef DefaultSPITransferPolicy() {
+    SPITransferPolicyDef policy;
+    policy.MaxPolls = 1000;
+    policy.TimeoutMicros = 1000000;
+    policy.BackoffMinMicros = 100;
+    policy.BackoffMaxMicros = 5000;
+    policy.CancelOnTimeout = true;
+    return policy;
+}
+
+bool SPITransferAccountReply(SPITransferOutcomeDef &outcome, const SPITransferPolicyDef &policy, int status,
+                             unsigned int engineStatus, double elapsedMicros) {
+    if (status == 0) {
+        outcome.LastDeviceStatus = 0;
+        outcome.LastEngineStatus = engineStatus;
+        if (engineStatus != SPI_STATUS_STARTED_NO_DATA_TO_RECEIVE && engineStatus != SPI_STATUS_SUCCESSFUL) {
+            outcome.Outcome = SPI_TRANSFER_COMPLETED;
+            return true;
+        }
+        outcome.Polls++;
+    } else if (status == SPI_STATUS_BUS_NOT_AVAILABLE || status == SPI_STATUS_TRANSFER_IN_PROGRESS) {
+        outcome.LastDeviceStatus = status;
+        outcome.BusyReplies++;
+    } else {
+        outcome.Outcome = SPI_TRANSFER_FAILED;
+        return true;
     }
 
-    return def;
+    // Busy replies count too: a bus held by another master must not loop forever
+    bool expired = (policy.MaxPolls > 0 && outcome.Polls + outcome.BusyReplies >= policy.MaxPolls)
+        || (policy.TimeoutMicros > 0 && elapsedMicros >= policy.TimeoutMicros);
+    if (!expired) {
+        return false;
+    }
+    outcome.Outcome = (outcome.Polls == 0 && outcome.LastDeviceStatus == SPI_STATUS_BUS_NOT_AVAILABLE)
+        ? SPI_TRANSFER_BUS_UNAVAILABLE : SPI_TRANSFER_TIMED_OUT;
+    outcome.Status.ErrorCode = ERROR_SPI_TRANSFER_TIMEOUT;
+    return true;
+}
+
+bool SPITransferNeedsCancel(const SPITransferOutcomeDef &outcome, const SPITransferPolicyDef &policy) {
+    // A transfer of ours is stuck in the engine: free it for the next one
+    return policy.CancelOnTimeout
+        && (outcome.Outcome == SPI_TRANSFER_TIMED_OUT || outcome.Outcome == SPI_TRANSFER_BUS_UNAVAILABLE)
+        && (outcome.Polls > 0 || outcome.LastDeviceStatus == SPI_STATUS_TRANSFER_IN_PROGRESS);
+}
+
+SPITransferOutcomeDef SPISendReceiveBounded(hid_device *handle, byte* data, int cmdBufferLength, int,
+                                            const SPITransferPolicyDef &policy) {
+    SPITransferOutcomeDef outcome = SPITransferOutcomeDef();
+    outcome.SPIBusCurrentOwner = SPI_BUS_OWNER_UNKNOWN;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    unsigned int backoff = policy.BackoffMinMicros;
+
+    for (;;) {
+        // The data is (re)submitted until the engine accepts it, then empty reports poll the engine
+        outcome.Status = SPIDataTransfer(handle, data, outcome.Polls > 0 ? 0 : cmdBufferLength);
+        int r = outcome.Status.ErrorCode;
+        double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        bool done = SPITransferAccountReply(outcome, policy, r, outcome.Status.SPIEngineStatus, elapsed);
+
+        if (r == SPI_STATUS_BUS_NOT_AVAILABLE) {
+            ChipStatusDef chip = GetChipStatus(handle);
+            if (chip.ErrorCode == 0) outcome.SPIBusCurrentOwner = chip.SPIBusCurrentOwner;
+        }
+        if (done) {
+            if (SPITransferNeedsCancel(outcome, policy)) {
+                ChipStatusDef chip = CancelSPITransfer(handle);
+                outcome.Cancelled = true;
+                if (chip.ErrorCode == 0) outcome.SPIBusCurrentOwner = chip.SPIBusCurrentOwner;
+            }
+            break;
+        }
+
+        // Busy replies are spaced out; engine polls are already paced by the USB round trip
+        if (r != 0 && backoff > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(backoff));
+            backoff = backoff * 2 < policy.BackoffMaxMicros ? backoff * 2 : policy.BackoffMaxMicros;
+        }
+    }
+
+    outcome.ElapsedMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return outcome;
 }
 
 ExternalInterruptPinStatusDef GetNumOfEventsFromInterruptPin(hid_device *handle, byte resetCounter) {
@@ -583,23 +728,123 @@ int SetGPIOPinVal(hid_device *handle, GPPinDef def) {
     return SendUSBCmd(handle, cmd, rsp);
 }
 
+int GetGPIOPinValueBits(hid_device *handle, unsigned int *bits) {
+    byte cmd[COMMAND_BUFFER_LENGTH];
+    byte rsp[RESPONSE_BUFFER_LENGTH];
+
+    memset(cmd, 0x0, COMMAND_BUFFER_LENGTH);
+    memset(rsp, 0x0, RESPONSE_BUFFER_LENGTH);
+
+    cmd[0] = CMD_GET_GPIO_PIN_VAL;
+
+    int r = SendUSBCmd(handle, cmd, rsp);
+
+    if (r == 0)
+        *bits = ((rsp[5] & 0x1) << 8 | rsp[4]) & GPIO_PIN_MASK;
+
+    return r;
+}
+
+int SetGPIOPinValueBits(hid_device *handle, unsigned int bits) {
+    byte cmd[COMMAND_BUFFER_LENGTH];
+    byte rsp[RESPONSE_BUFFER_LENGTH];
+
+    memset(cmd, 0x0, COMMAND_BUFFER_LENGTH);
+    memset(rsp, 0x0, RESPONSE_BUFFER_LENGTH);
+
+    cmd[0] = CMD_SET_GPIO_PIN_VAL;
+    cmd[4] = bits & 0xff;
+    cmd[5] = (bits >> 8) & 0x1;
+
+    return SendUSBCmd(handle, cmd, rsp);
+}
+
+int GetGPIOPinDirectionBits(hid_device *handle, unsigned int *bits) {
+    byte cmd[COMMAND_BUFFER_LENGTH];
+    byte rsp[RESPONSE_BUFFER_LENGTH];
+
+    memset(cmd, 0x0, COMMAND_BUFFER_LENGTH);
+    memset(rsp, 0x0, RESPONSE_BUFFER_LENGTH);
+
+    cmd[0] = CMD_GET_GPIO_PIN_DIR;
+
+    int r = SendUSBCmd(handle, cmd, rsp);
+
+    if (r == 0)
+        *bits = ((rsp[5] & 0x1) << 8 | rsp[4]) & GPIO_PIN_MASK;
+
+    return r;
+}
+
+int SetGPIOPinDirectionBits(hid_device *handle, unsigned int bits) {
+    byte cmd[COMMAND_BUFFER_LENGTH];
+    byte rsp[RESPONSE_BUFFER_LENGTH];
+
+    memset(cmd, 0x0, COMMAND_BUFFER_LENGTH);
+    memset(rsp, 0x0, RESPONSE_BUFFER_LENGTH);
+
+    cmd[0] = CMD_SET_GPIO_PIN_DIR;
+    cmd[4] = bits & 0xff;
+    cmd[5] = (bits >> 8) & 0x1;
+
+    return SendUSBCmd(handle, cmd, rsp);
+}
+
 hid_device_info* EnumerateMCP2210() {
     return hid_enumerate(MCP2210_VID, MCP2210_PID);
 }
 
 hid_device* InitMCP2210(unsigned short vid, unsigned short pid, wchar_t* serialNumber) {
+    if (transportSlots[0].ops) return DefaultTransportHandle();
     return hid_open(vid, pid, serialNumber);    
 }
 
+hid_device* InitMCP2210ByPath(const char *path, unsigned short vid, unsigned short pid, const wchar_t *serialNumber) {
+    if (transportSlots[0].ops) return DefaultTransportHandle();
+
+#ifdef __linux__
+    // One ioctl on the node instead of a udev scan: a renumbered hidrawN is rejected here
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    struct hidraw_devinfo info;
+    int r = ioctl(fd, HIDIOCGRAWINFO, &info);
+    close(fd);
+    if (r < 0 || static_cast<unsigned short>(info.vendor) != vid || static_cast<unsigned short>(info.product) != pid) {
+        return NULL;
+    }
+#endif
+
+    hid_device *handle = hid_open_path(path);
+    if (!handle) return NULL;
+
+#ifndef __linux__
+    struct hid_device_info *info = hid_get_device_info(handle);
+    if (!info || info->vendor_id != vid || info->product_id != pid) {
+        hid_close(handle);
+        return NULL;
+    }
+#endif
+
+    if (serialNumber) {
+        wchar_t serial[64] = {0};
+        if (hid_get_serial_number_string(handle, serial, 64) < 0 || wcscmp(serial, serialNumber) != 0) {
+            hid_close(handle);
+            return NULL;
+        }
+    }
+    return handle;
+}
+
 hid_device* InitMCP2210(wchar_t* serialNumber) {
-    return hid_open(MCP2210_VID, MCP2210_PID, serialNumber);
+    return InitMCP2210(MCP2210_VID, MCP2210_PID, serialNumber);
 }
 
 hid_device* InitMCP2210() {
-    return hid_open(MCP2210_VID, MCP2210_PID, NULL);
+    return InitMCP2210(MCP2210_VID, MCP2210_PID, NULL);
 }
 
 void ReleaseMCP2210(hid_device *handle) {
+    if (IsMCP2210VirtualDevice(handle)) return;
     hid_close(handle);
     hid_exit();
 }
\ No newline at end of file